@@ -0,0 +1,19 @@
+#include "Broadphase.h"
+#include "BruteForceBroadphase.h"
+#include "DynamicAABBTree.h"
+#include "SpatialHashGrid.h"
+#include "SweepAndPrune.h"
+
+std::unique_ptr<IBroadphase> CreateBroadphase(BroadphaseType type) {
+	switch (type) {
+		case BROADPHASE_BRUTE_FORCE:
+			return std::make_unique<BruteForceBroadphase>();
+		case BROADPHASE_SAP:
+			return std::make_unique<SweepAndPrune>();
+		case BROADPHASE_TREE:
+			return std::make_unique<DynamicAABBTree>();
+		case BROADPHASE_GRID:
+		default:
+			return std::make_unique<SpatialHashGrid>();
+	}
+}
@@ -0,0 +1,126 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// B R O A D P H A S E
+/////////////////////////////////////////////////////////////////////////////
+// A broadphase keeps the boxes of every collider and finds the pairs that
+// could be touching without testing every collider against every other.
+// the pairs it returns still have to be tested box against box by the
+// caller, a broadphase is allowed to return pairs that do not overlap.
+/////////////////////////////////////////////////////////////////////////////
+
+//axis aligned box in world pixels, min is the top left corner
+struct AABB {
+	float minX;
+	float minY;
+	float maxX;
+	float maxY;
+
+	//boxes that only share an edge do not overlap, same as PairBatch::FindOverlaps
+	bool Overlaps(const AABB& other) const {
+		return minX < other.maxX && maxX > other.minX && minY < other.maxY && maxY > other.minY;
+	}
+
+	bool Contains(const AABB& other) const {
+		return minX <= other.minX && minY <= other.minY && maxX >= other.maxX && maxY >= other.maxY;
+	}
+
+	AABB Union(const AABB& other) const {
+		return { std::min(minX, other.minX), std::min(minY, other.minY), std::max(maxX, other.maxX), std::max(maxY, other.maxY) };
+	}
+
+	//checks the segment from start to end against the box, slab by slab. fraction is how far along the
+	//segment it enters the box, 0 when it starts inside
+	bool IntersectsSegment(float startX, float startY, float endX, float endY, float& fraction) const {
+		float enter = 0.0f;
+		float leave = 1.0f;
+		const float starts[2] = { startX, startY };
+		const float deltas[2] = { endX - startX, endY - startY };
+		const float mins[2] = { minX, minY };
+		const float maxs[2] = { maxX, maxY };
+		for (int axis = 0; axis < 2; axis++) {
+			if (deltas[axis] == 0.0f) {
+				//parallel to this slab, it is either always inside it or never
+				if (starts[axis] < mins[axis] || starts[axis] > maxs[axis]) {
+					return false;
+				}
+				continue;
+			}
+			const float inverse = 1.0f / deltas[axis];
+			float slabEnter = (mins[axis] - starts[axis]) * inverse;
+			float slabExit = (maxs[axis] - starts[axis]) * inverse;
+			if (slabEnter > slabExit) {
+				std::swap(slabEnter, slabExit);
+			}
+			enter = std::max(enter, slabEnter);
+			leave = std::min(leave, slabExit);
+			if (enter > leave) {
+				return false;
+			}
+		}
+		fraction = enter;
+		return true;
+	}
+};
+
+//layers a collider is on and the layers it collides with, see BoxColliderComponent
+struct CollisionFilter {
+	uint32_t layers = 0xffffffff;
+	uint32_t mask = 0xffffffff;
+
+	//each has to be on a layer in the other's mask
+	bool CanCollide(const CollisionFilter& other) const {
+		return (layers & other.mask) != 0 && (other.layers & mask) != 0;
+	}
+	bool operator ==(const CollisionFilter& other) const { return layers == other.layers && mask == other.mask; }
+	bool operator !=(const CollisionFilter& other) const { return !(*this == other); }
+};
+
+//two colliders that may be touching, by the ids they were inserted with. a is the smaller id
+struct CollisionPair {
+	int a;
+	int b;
+};
+
+class IBroadphase {
+	public:
+		virtual ~IBroadphase() = default;
+
+		//adds a collider. ids are small non negative numbers, entity ids, and are used as indexes
+		virtual void Insert(int id, const AABB& box) = 0;
+		//drops the collider, ids that were never inserted are ignored
+		virtual void Remove(int id) = 0;
+		//gives an inserted collider its new box
+		virtual void Move(int id, const AABB& box) = 0;
+		virtual bool Contains(int id) const = 0;
+		//sets the layers of an inserted collider. colliders are inserted on every layer colliding with every layer,
+		//pairs whose filters cannot collide are never returned
+		virtual void SetFilter(int id, const CollisionFilter& filter) = 0;
+
+		//appends every pair whose boxes may overlap, each pair once
+		virtual void FindPairs(std::vector<CollisionPair>& pairs) = 0;
+
+		//appends the id of every collider whose box may overlap the region, each id once
+		virtual void QueryRegion(const AABB& region, std::vector<int>& ids) const = 0;
+		//appends the id of every collider whose box may be crossed by the segment from start to end, each id once
+		virtual void QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const = 0;
+};
+
+//Selects the broadphase the collision system uses, so they can be compared on the same scene
+enum BroadphaseType {
+	BROADPHASE_BRUTE_FORCE,	//every collider against every other
+	BROADPHASE_GRID,		//uniform spatial hash grid, see SpatialHashGrid
+	BROADPHASE_SAP,			//sweep and prune on the x axis, see SweepAndPrune
+	BROADPHASE_TREE			//dynamic tree of boxes, see DynamicAABBTree
+};
+
+std::unique_ptr<IBroadphase> CreateBroadphase(BroadphaseType type);
+
+#endif
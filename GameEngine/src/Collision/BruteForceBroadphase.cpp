@@ -0,0 +1,72 @@
+#include "BruteForceBroadphase.h"
+#include <algorithm>
+
+void BruteForceBroadphase::Insert(int id, const AABB& box) {
+	if (id >= static_cast<int>(indexOf.size())) {
+		indexOf.resize(std::max(static_cast<size_t>(id) + 1, indexOf.size() * 2), -1);
+	}
+	if (indexOf[id] != -1) {
+		boxes[indexOf[id]] = box;
+		return;
+	}
+	indexOf[id] = static_cast<int>(ids.size());
+	ids.push_back(id);
+	boxes.push_back(box);
+	filters.push_back(CollisionFilter());
+}
+
+void BruteForceBroadphase::Remove(int id) {
+	if (!Contains(id)) {
+		return;
+	}
+	const int index = indexOf[id];
+	indexOf[ids.back()] = index;
+	ids[index] = ids.back();
+	boxes[index] = boxes.back();
+	filters[index] = filters.back();
+	ids.pop_back();
+	boxes.pop_back();
+	filters.pop_back();
+	indexOf[id] = -1;
+}
+
+void BruteForceBroadphase::Move(int id, const AABB& box) {
+	Insert(id, box);
+}
+
+bool BruteForceBroadphase::Contains(int id) const {
+	return id >= 0 && id < static_cast<int>(indexOf.size()) && indexOf[id] != -1;
+}
+
+void BruteForceBroadphase::SetFilter(int id, const CollisionFilter& filter) {
+	if (Contains(id)) {
+		filters[indexOf[id]] = filter;
+	}
+}
+
+void BruteForceBroadphase::FindPairs(std::vector<CollisionPair>& pairs) {
+	for (size_t i = 0; i < boxes.size(); i++) {
+		for (size_t j = i + 1; j < boxes.size(); j++) {
+			if (filters[i].CanCollide(filters[j]) && boxes[i].Overlaps(boxes[j])) {
+				pairs.push_back({ std::min(ids[i], ids[j]), std::max(ids[i], ids[j]) });
+			}
+		}
+	}
+}
+
+void BruteForceBroadphase::QueryRegion(const AABB& region, std::vector<int>& ids) const {
+	for (size_t i = 0; i < boxes.size(); i++) {
+		if (boxes[i].Overlaps(region)) {
+			ids.push_back(this->ids[i]);
+		}
+	}
+}
+
+void BruteForceBroadphase::QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const {
+	float fraction;
+	for (size_t i = 0; i < boxes.size(); i++) {
+		if (boxes[i].IntersectsSegment(startX, startY, endX, endY, fraction)) {
+			ids.push_back(this->ids[i]);
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef BRUTEFORCEBROADPHASE_H
+#define BRUTEFORCEBROADPHASE_H
+
+#include "Broadphase.h"
+#include <vector>
+
+//tests every collider against every other one. only worth it for a handful of colliders,
+//kept to compare the other broadphases against
+class BruteForceBroadphase : public IBroadphase {
+	public:
+		void Insert(int id, const AABB& box) override;
+		void Remove(int id) override;
+		void Move(int id, const AABB& box) override;
+		bool Contains(int id) const override;
+		void SetFilter(int id, const CollisionFilter& filter) override;
+		void FindPairs(std::vector<CollisionPair>& pairs) override;
+		void QueryRegion(const AABB& region, std::vector<int>& ids) const override;
+		void QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const override;
+
+	private:
+		//packed ids with their boxes and filters, and the position of each id in them (index = id, -1 when not inserted)
+		std::vector<int> ids;
+		std::vector<AABB> boxes;
+		std::vector<CollisionFilter> filters;
+		std::vector<int> indexOf;
+};
+
+#endif
@@ -0,0 +1,301 @@
+#include "DynamicAABBTree.h"
+#include <algorithm>
+
+DynamicAABBTree::DynamicAABBTree(float margin) : margin(margin) {
+}
+
+int DynamicAABBTree::AllocateNode() {
+	if (freeList == NULL_NODE) {
+		nodes.push_back(Node());
+		freeList = static_cast<int>(nodes.size()) - 1;
+		nodes[freeList].parent = NULL_NODE;
+	}
+	const int index = freeList;
+	freeList = nodes[index].parent;
+	Node& node = nodes[index];
+	node.parent = NULL_NODE;
+	node.children[0] = NULL_NODE;
+	node.children[1] = NULL_NODE;
+	node.filter = CollisionFilter();
+	node.height = 0;
+	node.id = -1;
+	return index;
+}
+
+void DynamicAABBTree::FreeNode(int index) {
+	nodes[index].parent = freeList;
+	nodes[index].height = -1;
+	freeList = index;
+}
+
+void DynamicAABBTree::Insert(int id, const AABB& box) {
+	if (id >= static_cast<int>(leafOf.size())) {
+		const size_t size = std::max(static_cast<size_t>(id) + 1, leafOf.size() * 2);
+		leafOf.resize(size, NULL_NODE);
+		boxes.resize(size);
+	}
+	if (leafOf[id] != NULL_NODE) {
+		Move(id, box);
+		return;
+	}
+	const int leaf = AllocateNode();
+	nodes[leaf].box = { box.minX - margin, box.minY - margin, box.maxX + margin, box.maxY + margin };
+	nodes[leaf].id = id;
+	leafOf[id] = leaf;
+	boxes[id] = box;
+	InsertLeaf(leaf);
+}
+
+void DynamicAABBTree::Remove(int id) {
+	if (!Contains(id)) {
+		return;
+	}
+	const int leaf = leafOf[id];
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	leafOf[id] = NULL_NODE;
+}
+
+void DynamicAABBTree::Move(int id, const AABB& box) {
+	if (!Contains(id)) {
+		Insert(id, box);
+		return;
+	}
+	boxes[id] = box;
+	const int leaf = leafOf[id];
+	//most moves stay inside the grown box
+	if (nodes[leaf].box.Contains(box)) {
+		return;
+	}
+	RemoveLeaf(leaf);
+	nodes[leaf].box = { box.minX - margin, box.minY - margin, box.maxX + margin, box.maxY + margin };
+	InsertLeaf(leaf);
+}
+
+bool DynamicAABBTree::Contains(int id) const {
+	return id >= 0 && id < static_cast<int>(leafOf.size()) && leafOf[id] != NULL_NODE;
+}
+
+void DynamicAABBTree::SetFilter(int id, const CollisionFilter& filter) {
+	if (!Contains(id) || nodes[leafOf[id]].filter == filter) {
+		return;
+	}
+	const int leaf = leafOf[id];
+	nodes[leaf].filter = filter;
+	//the shape of the tree does not change, only the filters above the leaf
+	for (int index = nodes[leaf].parent; index != NULL_NODE; index = nodes[index].parent) {
+		Node& node = nodes[index];
+		node.filter = Combine(nodes[node.children[0]].filter, nodes[node.children[1]].filter);
+	}
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf) {
+	if (root == NULL_NODE) {
+		root = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	//walk down to the node that grows the least, by perimeter, when the leaf is paired with it
+	const AABB leafBox = nodes[leaf].box;
+	int index = root;
+	while (!nodes[index].IsLeaf()) {
+		const Node& node = nodes[index];
+		const float perimeter = Perimeter(node.box);
+		const float combinedPerimeter = Perimeter(node.box.Union(leafBox));
+		//cost of a new parent for this node and the leaf
+		const float cost = 2.0f * combinedPerimeter;
+		//every node above the new one grows by at least this much
+		const float inheritedCost = 2.0f * (combinedPerimeter - perimeter);
+
+		float childCosts[2];
+		for (int i = 0; i < 2; i++) {
+			const Node& child = nodes[node.children[i]];
+			const float grownPerimeter = Perimeter(child.box.Union(leafBox));
+			childCosts[i] = (child.IsLeaf() ? grownPerimeter : grownPerimeter - Perimeter(child.box)) + inheritedCost;
+		}
+		if (cost < childCosts[0] && cost < childCosts[1]) {
+			break;
+		}
+		index = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+	}
+
+	//a new parent takes the sibling's place with the sibling and the leaf under it
+	const int sibling = index;
+	const int oldParent = nodes[sibling].parent;
+	const int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = leafBox.Union(nodes[sibling].box);
+	nodes[newParent].filter = Combine(nodes[leaf].filter, nodes[sibling].filter);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].children[0] = sibling;
+	nodes[newParent].children[1] = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if (oldParent == NULL_NODE) {
+		root = newParent;
+	}
+	else {
+		Node& parent = nodes[oldParent];
+		parent.children[parent.children[0] == sibling ? 0 : 1] = newParent;
+	}
+
+	Refit(nodes[leaf].parent);
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf) {
+	if (leaf == root) {
+		root = NULL_NODE;
+		return;
+	}
+
+	//the sibling takes the parent's place and the parent is dropped
+	const int parent = nodes[leaf].parent;
+	const int grandParent = nodes[parent].parent;
+	const int sibling = nodes[parent].children[nodes[parent].children[0] == leaf ? 1 : 0];
+	nodes[sibling].parent = grandParent;
+	FreeNode(parent);
+	if (grandParent == NULL_NODE) {
+		root = sibling;
+		return;
+	}
+	Node& node = nodes[grandParent];
+	node.children[node.children[0] == parent ? 0 : 1] = sibling;
+	Refit(grandParent);
+}
+
+void DynamicAABBTree::Refit(int index) {
+	while (index != NULL_NODE) {
+		index = Balance(index);
+		Node& node = nodes[index];
+		const Node& first = nodes[node.children[0]];
+		const Node& second = nodes[node.children[1]];
+		node.height = 1 + std::max(first.height, second.height);
+		node.box = first.box.Union(second.box);
+		node.filter = Combine(first.filter, second.filter);
+		index = node.parent;
+	}
+}
+
+int DynamicAABBTree::Balance(int indexA) {
+	Node& a = nodes[indexA];
+	if (a.IsLeaf() || a.height < 2) {
+		return indexA;
+	}
+	const int indexB = a.children[0];
+	const int indexC = a.children[1];
+	const int balance = nodes[indexC].height - nodes[indexB].height;
+	if (balance >= -1 && balance <= 1) {
+		return indexA;
+	}
+
+	//the taller child moves up into a's place, a becomes its child and takes the taller
+	//child's shorter child. the side a is on and the side it gives up mirror each other
+	const int tallSide = balance > 1 ? 1 : 0;
+	const int indexUp = a.children[tallSide];
+	const int indexOther = a.children[1 - tallSide];
+	Node& up = nodes[indexUp];
+	const int indexF = up.children[0];
+	const int indexG = up.children[1];
+
+	up.children[0] = indexA;
+	up.parent = a.parent;
+	a.parent = indexUp;
+	if (up.parent == NULL_NODE) {
+		root = indexUp;
+	}
+	else {
+		Node& parent = nodes[up.parent];
+		parent.children[parent.children[0] == indexA ? 0 : 1] = indexUp;
+	}
+
+	//the taller grandchild stays with up, the shorter one goes to a
+	const bool isFTaller = nodes[indexF].height > nodes[indexG].height;
+	const int indexKept = isFTaller ? indexF : indexG;
+	const int indexGiven = isFTaller ? indexG : indexF;
+	up.children[1] = indexKept;
+	a.children[tallSide] = indexGiven;
+	nodes[indexGiven].parent = indexA;
+
+	a.box = nodes[indexOther].box.Union(nodes[indexGiven].box);
+	a.height = 1 + std::max(nodes[indexOther].height, nodes[indexGiven].height);
+	a.filter = Combine(nodes[indexOther].filter, nodes[indexGiven].filter);
+	up.box = a.box.Union(nodes[indexKept].box);
+	up.filter = Combine(a.filter, nodes[indexKept].filter);
+	up.height = 1 + std::max(a.height, nodes[indexKept].height);
+	return indexUp;
+}
+
+void DynamicAABBTree::FindPairs(std::vector<CollisionPair>& pairs) {
+	//every collider walks the tree with its exact box, pairs are added from the smaller id only
+	for (int id = 0; id < static_cast<int>(leafOf.size()); id++) {
+		if (leafOf[id] == NULL_NODE) {
+			continue;
+		}
+		const AABB& box = boxes[id];
+		const CollisionFilter& filter = nodes[leafOf[id]].filter;
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty()) {
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+			//a branch without a layer the collider collides with is skipped before its box is looked at
+			if (!node.filter.CanCollide(filter) || !node.box.Overlaps(box)) {
+				continue;
+			}
+			if (node.IsLeaf()) {
+				if (node.id > id && boxes[node.id].Overlaps(box)) {
+					pairs.push_back({ id, node.id });
+				}
+				continue;
+			}
+			stack.push_back(node.children[0]);
+			stack.push_back(node.children[1]);
+		}
+	}
+}
+
+void DynamicAABBTree::QueryRegion(const AABB& region, std::vector<int>& ids) const {
+	if (root == NULL_NODE) {
+		return;
+	}
+	std::vector<int> nodesToVisit(1, root);
+	while (!nodesToVisit.empty()) {
+		const Node& node = nodes[nodesToVisit.back()];
+		nodesToVisit.pop_back();
+		if (!node.box.Overlaps(region)) {
+			continue;
+		}
+		if (node.IsLeaf()) {
+			if (boxes[node.id].Overlaps(region)) {
+				ids.push_back(node.id);
+			}
+			continue;
+		}
+		nodesToVisit.push_back(node.children[0]);
+		nodesToVisit.push_back(node.children[1]);
+	}
+}
+
+void DynamicAABBTree::QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const {
+	if (root == NULL_NODE) {
+		return;
+	}
+	float fraction;
+	std::vector<int> nodesToVisit(1, root);
+	while (!nodesToVisit.empty()) {
+		const Node& node = nodes[nodesToVisit.back()];
+		nodesToVisit.pop_back();
+		if (!node.box.IntersectsSegment(startX, startY, endX, endY, fraction)) {
+			continue;
+		}
+		if (node.IsLeaf()) {
+			if (boxes[node.id].IntersectsSegment(startX, startY, endX, endY, fraction)) {
+				ids.push_back(node.id);
+			}
+			continue;
+		}
+		nodesToVisit.push_back(node.children[0]);
+		nodesToVisit.push_back(node.children[1]);
+	}
+}
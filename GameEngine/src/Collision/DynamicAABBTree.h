@@ -0,0 +1,90 @@
+#ifndef DYNAMICAABBTREE_H
+#define DYNAMICAABBTREE_H
+
+#include "Broadphase.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// D Y N A M I C   A A B B   T R E E
+/////////////////////////////////////////////////////////////////////////////
+// Bounding volume tree broadphase. every collider is a leaf and every inner
+// node holds the box around its two children, so a query only walks down
+// the parts of the tree whose boxes it touches. unlike the grid it does not
+// care how spread out the colliders are: crowded bases and empty space cost
+// the same per collider.
+// leaves hold a box grown by a margin on each side. a collider that moves
+// but stays inside its grown box does not touch the tree, one that leaves
+// it is taken out and put back in, which is O(log n) since the tree is kept
+// balanced by rotating nodes on the way back up.
+// inner nodes also hold the layers and masks of everything under them, so
+// a collider skips whole branches it cannot collide with.
+/////////////////////////////////////////////////////////////////////////////
+
+class DynamicAABBTree : public IBroadphase {
+	public:
+		DynamicAABBTree(float margin = 8.0f);
+
+		void Insert(int id, const AABB& box) override;
+		void Remove(int id) override;
+		void Move(int id, const AABB& box) override;
+		bool Contains(int id) const override;
+		void SetFilter(int id, const CollisionFilter& filter) override;
+		void FindPairs(std::vector<CollisionPair>& pairs) override;
+		void QueryRegion(const AABB& region, std::vector<int>& ids) const override;
+		void QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const override;
+
+		float GetMargin() const { return margin; }
+		//longest path from the root to a leaf, 0 when empty
+		int GetHeight() const { return root == NULL_NODE ? 0 : nodes[root].height + 1; }
+
+	private:
+		static constexpr int NULL_NODE = -1;
+
+		struct Node {
+			//grown box for a leaf, box around both children for an inner node
+			AABB box;
+			//filter of a leaf, every layer and every mask under an inner node
+			CollisionFilter filter;
+			//next free node while the node is on the free list
+			int parent;
+			int children[2];
+			//0 for a leaf
+			int height;
+			//collider id of a leaf, -1 for an inner node
+			int id;
+
+			bool IsLeaf() const { return children[0] == NULL_NODE; }
+		};
+
+		int AllocateNode();
+		void FreeNode(int index);
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+		//rotates the taller grandchild up when the children of a node differ in height by more than one,
+		//returns the node that now sits where index was
+		int Balance(int index);
+		//works out box and height of every node from index up to the root, balancing on the way
+		void Refit(int index);
+
+		static CollisionFilter Combine(const CollisionFilter& a, const CollisionFilter& b) {
+			CollisionFilter filter;
+			filter.layers = a.layers | b.layers;
+			filter.mask = a.mask | b.mask;
+			return filter;
+		}
+		static float Perimeter(const AABB& box) {
+			return 2.0f * ((box.maxX - box.minX) + (box.maxY - box.minY));
+		}
+
+		float margin;
+		std::vector<Node> nodes;
+		int root = NULL_NODE;
+		int freeList = NULL_NODE;
+		//leaf of each collider and its exact box, index = id. NULL_NODE when not inserted
+		std::vector<int> leafOf;
+		std::vector<AABB> boxes;
+		//nodes still to visit during FindPairs, kept to reuse the memory
+		std::vector<int> stack;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "Narrowphase.h"
+
+//8 wide compares need AVX, which /arch:AVX and /arch:AVX2 turn on. SSE2 is always there on x64
+#if defined(__AVX__)
+#include <immintrin.h>
+#define NARROWPHASE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NARROWPHASE_SSE2
+#endif
+
+void PairBatch::Clear() {
+	aMinX.clear();
+	aMinY.clear();
+	aMaxX.clear();
+	aMaxY.clear();
+	bMinX.clear();
+	bMinY.clear();
+	bMaxX.clear();
+	bMaxY.clear();
+}
+
+void PairBatch::Add(const AABB& a, const AABB& b) {
+	aMinX.push_back(a.minX);
+	aMinY.push_back(a.minY);
+	aMaxX.push_back(a.maxX);
+	aMaxY.push_back(a.maxY);
+	bMinX.push_back(b.minX);
+	bMinY.push_back(b.minY);
+	bMaxX.push_back(b.maxX);
+	bMaxY.push_back(b.maxY);
+}
+
+void PairBatch::FindOverlaps(std::vector<int>& overlapping) const {
+	const int size = GetSize();
+	int i = 0;
+
+#if defined(NARROWPHASE_AVX)
+	for (; i + 8 <= size; i += 8) {
+		const __m256 x = _mm256_and_ps(
+			_mm256_cmp_ps(_mm256_loadu_ps(&aMinX[i]), _mm256_loadu_ps(&bMaxX[i]), _CMP_LT_OQ),
+			_mm256_cmp_ps(_mm256_loadu_ps(&aMaxX[i]), _mm256_loadu_ps(&bMinX[i]), _CMP_GT_OQ));
+		const __m256 y = _mm256_and_ps(
+			_mm256_cmp_ps(_mm256_loadu_ps(&aMinY[i]), _mm256_loadu_ps(&bMaxY[i]), _CMP_LT_OQ),
+			_mm256_cmp_ps(_mm256_loadu_ps(&aMaxY[i]), _mm256_loadu_ps(&bMinY[i]), _CMP_GT_OQ));
+		//one bit per pair, most groups have no overlap at all
+		int mask = _mm256_movemask_ps(_mm256_and_ps(x, y));
+		for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+			if (mask & 1) {
+				overlapping.push_back(i + lane);
+			}
+		}
+	}
+#elif defined(NARROWPHASE_SSE2)
+	for (; i + 4 <= size; i += 4) {
+		const __m128 x = _mm_and_ps(
+			_mm_cmplt_ps(_mm_loadu_ps(&aMinX[i]), _mm_loadu_ps(&bMaxX[i])),
+			_mm_cmpgt_ps(_mm_loadu_ps(&aMaxX[i]), _mm_loadu_ps(&bMinX[i])));
+		const __m128 y = _mm_and_ps(
+			_mm_cmplt_ps(_mm_loadu_ps(&aMinY[i]), _mm_loadu_ps(&bMaxY[i])),
+			_mm_cmpgt_ps(_mm_loadu_ps(&aMaxY[i]), _mm_loadu_ps(&bMinY[i])));
+		//one bit per pair, most groups have no overlap at all
+		int mask = _mm_movemask_ps(_mm_and_ps(x, y));
+		for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+			if (mask & 1) {
+				overlapping.push_back(i + lane);
+			}
+		}
+	}
+#endif
+
+	for (; i < size; i++) {
+		if (aMinX[i] < bMaxX[i] && aMaxX[i] > bMinX[i] && aMinY[i] < bMaxY[i] && aMaxY[i] > bMinY[i]) {
+			overlapping.push_back(i);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+#include "Broadphase.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// N A R R O W P H A S E
+/////////////////////////////////////////////////////////////////////////////
+// Tests the pairs the broadphase found box against box, many at a time.
+// the boxes of every pair are copied into one array per edge, so a group
+// of pairs is tested with a handful of vector compares: 8 pairs at once
+// with AVX, 4 with SSE2, and one by one on anything else. the leftover
+// pairs at the end of the batch are tested one by one as well.
+/////////////////////////////////////////////////////////////////////////////
+
+class PairBatch {
+	public:
+		void Clear();
+		void Add(const AABB& a, const AABB& b);
+		int GetSize() const { return static_cast<int>(aMinX.size()); }
+
+		//appends the position in the batch of every pair whose boxes overlap, in order.
+		//boxes that only share an edge do not overlap, same as AABB::Overlaps
+		void FindOverlaps(std::vector<int>& overlapping) const;
+
+	private:
+		//one array per edge, index = position of the pair in the batch
+		std::vector<float> aMinX;
+		std::vector<float> aMinY;
+		std::vector<float> aMaxX;
+		std::vector<float> aMaxY;
+		std::vector<float> bMinX;
+		std::vector<float> bMinY;
+		std::vector<float> bMaxX;
+		std::vector<float> bMaxY;
+};
+
+#endif
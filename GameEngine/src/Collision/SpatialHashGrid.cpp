@@ -0,0 +1,211 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHashGrid::SpatialHashGrid(float cellSize) : cellSize(cellSize), inverseCellSize(1.0f / cellSize) {
+}
+
+SpatialHashGrid::CellRange SpatialHashGrid::GetCellRange(const AABB& box) const {
+	return {
+		static_cast<int>(std::floor(box.minX * inverseCellSize)),
+		static_cast<int>(std::floor(box.minY * inverseCellSize)),
+		static_cast<int>(std::floor(box.maxX * inverseCellSize)),
+		static_cast<int>(std::floor(box.maxY * inverseCellSize))
+	};
+}
+
+void SpatialHashGrid::AddToCell(int id, int x, int y) {
+	const int64_t key = GetCellKey(x, y);
+	auto cellIndex = cellIndexByKey.find(key);
+	if (cellIndex == cellIndexByKey.end()) {
+		cellIndex = cellIndexByKey.emplace(key, static_cast<int>(cells.size())).first;
+		cells.push_back({ x, y, {}, 0, 0 });
+	}
+	Cell& cell = cells[cellIndex->second];
+	cell.ids.push_back(id);
+	cell.layers |= proxies[id].filter.layers;
+	cell.masks |= proxies[id].filter.mask;
+}
+
+void SpatialHashGrid::RefreshCellFilter(Cell& cell) const {
+	cell.layers = 0;
+	cell.masks = 0;
+	for (int id : cell.ids) {
+		cell.layers |= proxies[id].filter.layers;
+		cell.masks |= proxies[id].filter.mask;
+	}
+}
+
+void SpatialHashGrid::RemoveFromCell(int id, int x, int y) {
+	auto cellIndex = cellIndexByKey.find(GetCellKey(x, y));
+	if (cellIndex == cellIndexByKey.end()) {
+		return;
+	}
+	const int index = cellIndex->second;
+	std::vector<int>& ids = cells[index].ids;
+	auto position = std::find(ids.begin(), ids.end(), id);
+	if (position != ids.end()) {
+		*position = ids.back();
+		ids.pop_back();
+	}
+
+	//an empty cell is dropped, the last cell takes its place in the packed vector
+	if (ids.empty()) {
+		cellIndexByKey.erase(cellIndex);
+		if (index != static_cast<int>(cells.size()) - 1) {
+			cells[index] = std::move(cells.back());
+			cellIndexByKey[GetCellKey(cells[index].x, cells[index].y)] = index;
+		}
+		cells.pop_back();
+	}
+	//the layers of the collider that left may still be used by others, so they are put together again
+	else {
+		RefreshCellFilter(cells[index]);
+	}
+}
+
+void SpatialHashGrid::Insert(int id, const AABB& box) {
+	if (id >= static_cast<int>(proxies.size())) {
+		proxies.resize(std::max(static_cast<size_t>(id) + 1, proxies.size() * 2));
+	}
+	if (proxies[id].isInserted) {
+		Move(id, box);
+		return;
+	}
+	Proxy& proxy = proxies[id];
+	proxy.range = GetCellRange(box);
+	proxy.filter = CollisionFilter();
+	proxy.isInserted = true;
+	for (int y = proxy.range.minY; y <= proxy.range.maxY; y++) {
+		for (int x = proxy.range.minX; x <= proxy.range.maxX; x++) {
+			AddToCell(id, x, y);
+		}
+	}
+}
+
+void SpatialHashGrid::Remove(int id) {
+	if (!Contains(id)) {
+		return;
+	}
+	Proxy& proxy = proxies[id];
+	for (int y = proxy.range.minY; y <= proxy.range.maxY; y++) {
+		for (int x = proxy.range.minX; x <= proxy.range.maxX; x++) {
+			RemoveFromCell(id, x, y);
+		}
+	}
+	proxy.isInserted = false;
+}
+
+void SpatialHashGrid::Move(int id, const AABB& box) {
+	if (!Contains(id)) {
+		Insert(id, box);
+		return;
+	}
+	Proxy& proxy = proxies[id];
+	const CellRange oldRange = proxy.range;
+	const CellRange newRange = GetCellRange(box);
+	//most moves stay inside the same cells
+	if (newRange == oldRange) {
+		return;
+	}
+
+	//only the cells the box left or entered change
+	auto isInside = [](const CellRange& range, int x, int y) {
+		return x >= range.minX && x <= range.maxX && y >= range.minY && y <= range.maxY;
+	};
+	for (int y = oldRange.minY; y <= oldRange.maxY; y++) {
+		for (int x = oldRange.minX; x <= oldRange.maxX; x++) {
+			if (!isInside(newRange, x, y)) {
+				RemoveFromCell(id, x, y);
+			}
+		}
+	}
+	for (int y = newRange.minY; y <= newRange.maxY; y++) {
+		for (int x = newRange.minX; x <= newRange.maxX; x++) {
+			if (!isInside(oldRange, x, y)) {
+				AddToCell(id, x, y);
+			}
+		}
+	}
+	proxy.range = newRange;
+}
+
+bool SpatialHashGrid::Contains(int id) const {
+	return id >= 0 && id < static_cast<int>(proxies.size()) && proxies[id].isInserted;
+}
+
+void SpatialHashGrid::SetFilter(int id, const CollisionFilter& filter) {
+	if (!Contains(id) || proxies[id].filter == filter) {
+		return;
+	}
+	Proxy& proxy = proxies[id];
+	proxy.filter = filter;
+	for (int y = proxy.range.minY; y <= proxy.range.maxY; y++) {
+		for (int x = proxy.range.minX; x <= proxy.range.maxX; x++) {
+			auto cellIndex = cellIndexByKey.find(GetCellKey(x, y));
+			if (cellIndex != cellIndexByKey.end()) {
+				RefreshCellFilter(cells[cellIndex->second]);
+			}
+		}
+	}
+}
+
+void SpatialHashGrid::FindPairs(std::vector<CollisionPair>& pairs) {
+	for (const Cell& cell : cells) {
+		//no collider in the cell is on a layer any of the others collide with, e.g. a cell of only tiles
+		if ((cell.layers & cell.masks) == 0) {
+			continue;
+		}
+		const std::vector<int>& ids = cell.ids;
+		for (size_t i = 0; i < ids.size(); i++) {
+			const CellRange& a = proxies[ids[i]].range;
+			const CollisionFilter& filterA = proxies[ids[i]].filter;
+			for (size_t j = i + 1; j < ids.size(); j++) {
+				if (!filterA.CanCollide(proxies[ids[j]].filter)) {
+					continue;
+				}
+				const CellRange& b = proxies[ids[j]].range;
+				//colliders that share several cells are paired only in the top left one they share
+				if (std::max(a.minX, b.minX) != cell.x || std::max(a.minY, b.minY) != cell.y) {
+					continue;
+				}
+				pairs.push_back({ std::min(ids[i], ids[j]), std::max(ids[i], ids[j]) });
+			}
+		}
+	}
+}
+
+void SpatialHashGrid::QueryRegion(const AABB& region, std::vector<int>& ids) const {
+	const CellRange range = GetCellRange(region);
+	const size_t first = ids.size();
+	auto addCell = [&ids](const Cell& cell) {
+		ids.insert(ids.end(), cell.ids.begin(), cell.ids.end());
+	};
+	//a region covering more cells than there are in use walks the cells in use instead
+	const int64_t numCellsInRange = (static_cast<int64_t>(range.maxX) - range.minX + 1) * (static_cast<int64_t>(range.maxY) - range.minY + 1);
+	if (numCellsInRange > static_cast<int64_t>(cells.size())) {
+		for (const Cell& cell : cells) {
+			if (cell.x >= range.minX && cell.x <= range.maxX && cell.y >= range.minY && cell.y <= range.maxY) {
+				addCell(cell);
+			}
+		}
+	}
+	else {
+		for (int y = range.minY; y <= range.maxY; y++) {
+			for (int x = range.minX; x <= range.maxX; x++) {
+				auto cellIndex = cellIndexByKey.find(GetCellKey(x, y));
+				if (cellIndex != cellIndexByKey.end()) {
+					addCell(cells[cellIndex->second]);
+				}
+			}
+		}
+	}
+	//colliders listed in several of the cells are only returned once
+	std::sort(ids.begin() + first, ids.end());
+	ids.erase(std::unique(ids.begin() + first, ids.end()), ids.end());
+}
+
+//the grid does not keep the boxes, so every collider in the cells under the segment's bounds is returned
+void SpatialHashGrid::QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const {
+	QueryRegion({ std::min(startX, endX), std::min(startY, endY), std::max(startX, endX), std::max(startY, endY) }, ids);
+}
@@ -0,0 +1,83 @@
+#ifndef SPATIALHASHGRID_H
+#define SPATIALHASHGRID_H
+
+#include "Broadphase.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// S P A T I A L   H A S H   G R I D
+/////////////////////////////////////////////////////////////////////////////
+// Uniform grid broadphase. every collider is listed in each cell its box
+// covers, and only colliders listed in the same cell are paired. cells are
+// made when something enters them and dropped once empty, so an unbounded
+// map only costs memory where there are colliders. a collider that moves
+// but stays in the same cells does not touch the grid at all.
+// the cell size should be about the size of a typical collider: much
+// smaller and big colliders are listed in many cells, much larger and the
+// cells fill up with colliders that are far apart.
+// every cell also keeps the layers and masks of its colliders put together,
+// a cell where none of them can collide with each other is skipped whole.
+/////////////////////////////////////////////////////////////////////////////
+
+class SpatialHashGrid : public IBroadphase {
+	public:
+		SpatialHashGrid(float cellSize = 64.0f);
+
+		void Insert(int id, const AABB& box) override;
+		void Remove(int id) override;
+		void Move(int id, const AABB& box) override;
+		bool Contains(int id) const override;
+		void SetFilter(int id, const CollisionFilter& filter) override;
+		void FindPairs(std::vector<CollisionPair>& pairs) override;
+		void QueryRegion(const AABB& region, std::vector<int>& ids) const override;
+		void QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const override;
+
+		float GetCellSize() const { return cellSize; }
+		int GetNumCells() const { return static_cast<int>(cells.size()); }
+
+	private:
+		//cells covered by a box, inclusive
+		struct CellRange {
+			int minX;
+			int minY;
+			int maxX;
+			int maxY;
+			bool operator ==(const CellRange& other) const {
+				return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+			}
+		};
+		struct Cell {
+			int x;
+			int y;
+			std::vector<int> ids;
+			//every layer and every mask of the colliders in the cell
+			uint32_t layers;
+			uint32_t masks;
+		};
+		struct Proxy {
+			CellRange range;
+			CollisionFilter filter;
+			bool isInserted = false;
+		};
+
+		CellRange GetCellRange(const AABB& box) const;
+		static int64_t GetCellKey(int x, int y) {
+			return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y));
+		}
+		void AddToCell(int id, int x, int y);
+		void RemoveFromCell(int id, int x, int y);
+		void RefreshCellFilter(Cell& cell) const;
+
+		float cellSize;
+		float inverseCellSize;
+		//cells that have colliders, packed so FindPairs walks them in order
+		std::vector<Cell> cells;
+		//position in cells of each cell, key = GetCellKey
+		std::unordered_map<int64_t, int> cellIndexByKey;
+		//index = id
+		std::vector<Proxy> proxies;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+void SweepAndPrune::Insert(int id, const AABB& box) {
+	if (id >= static_cast<int>(boxes.size())) {
+		const size_t size = std::max(static_cast<size_t>(id) + 1, boxes.size() * 2);
+		boxes.resize(size);
+		filters.resize(size);
+		isInserted.resize(size, false);
+		generations.resize(size, 0);
+		openIndex.resize(size, -1);
+	}
+	if (isInserted[id]) {
+		Move(id, box);
+		return;
+	}
+	boxes[id] = box;
+	filters[id] = CollisionFilter();
+	isInserted[id] = true;
+	//kept apart until the next FindPairs sorts them and merges them into endpoints
+	newEndpoints.push_back({ box.minX, id, generations[id], true });
+	newEndpoints.push_back({ box.maxX, id, generations[id], false });
+}
+
+void SweepAndPrune::Remove(int id) {
+	if (!Contains(id)) {
+		return;
+	}
+	//the endpoints stay until the next FindPairs, a new generation keeps them apart from the ones of a reinsert
+	isInserted[id] = false;
+	generations[id]++;
+	numStaleEndpoints += 2;
+}
+
+void SweepAndPrune::Move(int id, const AABB& box) {
+	if (!Contains(id)) {
+		Insert(id, box);
+		return;
+	}
+	//the endpoints pick up the new x in FindPairs
+	boxes[id] = box;
+}
+
+bool SweepAndPrune::Contains(int id) const {
+	return id >= 0 && id < static_cast<int>(isInserted.size()) && isInserted[id];
+}
+
+void SweepAndPrune::SetFilter(int id, const CollisionFilter& filter) {
+	if (Contains(id)) {
+		filters[id] = filter;
+	}
+}
+
+void SweepAndPrune::FindPairs(std::vector<CollisionPair>& pairs) {
+	const auto isStale = [this](const Endpoint& endpoint) { return !IsLive(endpoint); };
+	if (numStaleEndpoints > 0) {
+		endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), isStale), endpoints.end());
+		newEndpoints.erase(std::remove_if(newEndpoints.begin(), newEndpoints.end(), isStale), newEndpoints.end());
+		numStaleEndpoints = 0;
+	}
+	for (std::vector<Endpoint>* list : { &endpoints, &newEndpoints }) {
+		for (Endpoint& endpoint : *list) {
+			const AABB& box = boxes[endpoint.id];
+			endpoint.x = endpoint.isMin ? box.minX : box.maxX;
+		}
+	}
+
+	//insertion sort of the endpoints that were already in place, each only moves past the few it crossed since the last frame
+	for (size_t i = 1; i < endpoints.size(); i++) {
+		if (!IsBefore(endpoints[i], endpoints[i - 1])) {
+			continue;
+		}
+		const Endpoint endpoint = endpoints[i];
+		size_t j = i;
+		for (; j > 0 && IsBefore(endpoint, endpoints[j - 1]); j--) {
+			endpoints[j] = endpoints[j - 1];
+		}
+		endpoints[j] = endpoint;
+	}
+	//the new ones can land anywhere, they are sorted on their own and merged in
+	if (!newEndpoints.empty()) {
+		const auto isBefore = [this](const Endpoint& a, const Endpoint& b) { return IsBefore(a, b); };
+		std::sort(newEndpoints.begin(), newEndpoints.end(), isBefore);
+		const size_t numSorted = endpoints.size();
+		endpoints.insert(endpoints.end(), newEndpoints.begin(), newEndpoints.end());
+		std::inplace_merge(endpoints.begin(), endpoints.begin() + numSorted, endpoints.end(), isBefore);
+		newEndpoints.clear();
+	}
+
+	openIds.clear();
+	for (const Endpoint& endpoint : endpoints) {
+		if (!endpoint.isMin) {
+			//swap the last open box into the closed one's place
+			const int index = openIndex[endpoint.id];
+			openIndex[openIds.back()] = index;
+			openIds[index] = openIds.back();
+			openIds.pop_back();
+			openIndex[endpoint.id] = -1;
+			continue;
+		}
+		//every open box overlaps this one on x
+		const AABB& box = boxes[endpoint.id];
+		const CollisionFilter& filter = filters[endpoint.id];
+		for (int openId : openIds) {
+			const AABB& open = boxes[openId];
+			if (filter.CanCollide(filters[openId]) && box.minY < open.maxY && box.maxY > open.minY) {
+				pairs.push_back({ std::min(endpoint.id, openId), std::max(endpoint.id, openId) });
+			}
+		}
+		openIndex[endpoint.id] = static_cast<int>(openIds.size());
+		openIds.push_back(endpoint.id);
+	}
+}
+
+//the endpoints are only sorted as of the last FindPairs, so queries go through every box,
+//including the ones inserted since then
+void SweepAndPrune::QueryRegion(const AABB& region, std::vector<int>& ids) const {
+	for (const std::vector<Endpoint>* list : { &endpoints, &newEndpoints }) {
+		for (const Endpoint& endpoint : *list) {
+			if (endpoint.isMin && IsLive(endpoint) && boxes[endpoint.id].Overlaps(region)) {
+				ids.push_back(endpoint.id);
+			}
+		}
+	}
+}
+
+void SweepAndPrune::QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const {
+	float fraction;
+	for (const std::vector<Endpoint>* list : { &endpoints, &newEndpoints }) {
+		for (const Endpoint& endpoint : *list) {
+			if (endpoint.isMin && IsLive(endpoint) && boxes[endpoint.id].IntersectsSegment(startX, startY, endX, endY, fraction)) {
+				ids.push_back(endpoint.id);
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include "Broadphase.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// S W E E P   A N D   P R U N E
+/////////////////////////////////////////////////////////////////////////////
+// Sort and sweep broadphase on the x axis. the start and end x of every box
+// are kept in one sorted array between frames. colliders only move a few
+// pixels a frame, so the array is nearly sorted already and an insertion
+// sort puts it back in order in close to one pass. boxes inserted since the
+// last frame are sorted on their own and merged in, so a burst of spawns
+// does not walk each new endpoint across the whole array. the sweep then walks the
+// array keeping the boxes whose x range is open, and pairs a box with the
+// open ones whose y range it overlaps. layers are checked before the y range.
+// removed boxes leave their endpoints behind until the next FindPairs drops
+// all of them in one pass, so killing many colliders in a frame stays cheap.
+/////////////////////////////////////////////////////////////////////////////
+
+class SweepAndPrune : public IBroadphase {
+	public:
+		void Insert(int id, const AABB& box) override;
+		void Remove(int id) override;
+		void Move(int id, const AABB& box) override;
+		bool Contains(int id) const override;
+		void SetFilter(int id, const CollisionFilter& filter) override;
+		void FindPairs(std::vector<CollisionPair>& pairs) override;
+		void QueryRegion(const AABB& region, std::vector<int>& ids) const override;
+		void QuerySegment(float startX, float startY, float endX, float endY, std::vector<int>& ids) const override;
+
+	private:
+		struct Endpoint {
+			float x;
+			int id;
+			//generation of the id when it was inserted, endpoints of an older generation were removed
+			unsigned int generation;
+			bool isMin;
+		};
+		//sorted by x. at the same x the ends come before the starts so boxes that only touch are not paired,
+		//but a box with no width has both at the same x and its end goes after the starts so its own start comes first
+		bool IsBefore(const Endpoint& a, const Endpoint& b) const {
+			if (a.x != b.x) {
+				return a.x < b.x;
+			}
+			return OrderAtSameX(a) < OrderAtSameX(b);
+		}
+		int OrderAtSameX(const Endpoint& endpoint) const {
+			if (endpoint.isMin) {
+				return 1;
+			}
+			return boxes[endpoint.id].minX == endpoint.x ? 2 : 0;
+		}
+		bool IsLive(const Endpoint& endpoint) const {
+			return isInserted[endpoint.id] && generations[endpoint.id] == endpoint.generation;
+		}
+
+		std::vector<Endpoint> endpoints;
+		//endpoints of the boxes inserted since the last FindPairs, not sorted yet
+		std::vector<Endpoint> newEndpoints;
+		//index = id
+		std::vector<AABB> boxes;
+		std::vector<CollisionFilter> filters;
+		std::vector<bool> isInserted;
+		std::vector<unsigned int> generations;
+		//endpoints of removed boxes still in endpoints or newEndpoints
+		int numStaleEndpoints = 0;
+		//boxes with an open x range during the sweep, and the position of each id in it
+		std::vector<int> openIds;
+		std::vector<int> openIndex;
+};
+
+#endif
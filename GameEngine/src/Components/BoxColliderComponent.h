@@ -1,17 +1,34 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <cstdint>
+
+//layers a collider can be on, one bit each so a collider can be on several
+enum CollisionLayer : uint32_t {
+	COLLISION_LAYER_DEFAULT = 1u << 0,
+	COLLISION_LAYER_TILE = 1u << 1,
+	COLLISION_LAYER_PLAYER = 1u << 2,
+	COLLISION_LAYER_ENEMY = 1u << 3,
+	COLLISION_LAYER_BULLET = 1u << 4
+};
+const uint32_t COLLISION_MASK_ALL = 0xffffffff;
 
 struct BoxColliderComponent {
 	int width;
 	int height;
 	glm::vec2 offset;
+	//layers the collider is on and the layers it collides with. two colliders are only tested
+	//when each one is on a layer in the other's mask, so bullets leave their own layer out of the mask
+	uint32_t layer;
+	uint32_t mask;
 
-	BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0))
+	BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0), uint32_t layer = COLLISION_LAYER_DEFAULT, uint32_t mask = COLLISION_MASK_ALL)
 	{
 		this->width = width;
 		this->height = height;
 		this->offset = offset;
+		this->layer = layer;
+		this->mask = mask;
 	}
 
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef COMPONENTLIST_H
+#define COMPONENTLIST_H
+
+#ifndef ECS_H
+#error "ComponentList.h is included by ECS/ECS.h when ECS_STATIC_COMPONENT_IDS is defined, include ECS.h instead"
+#endif
+
+#include "TransformComponent.h"
+#include "RigidBodyComponent.h"
+#include "SpriteComponent.h"
+#include "AnimationComponent.h"
+#include "BoxColliderComponent.h"
+#include "ParentComponent.h"
+#include "EnemyTag.h"
+#include "StaticTag.h"
+
+//Compile time component ids. a component's id is its position in the list,
+//so only append new components to the end to keep saved ids valid.
+template <>
+struct RegisteredComponents<void> {
+	typedef ComponentList<
+		TransformComponent,		// 0
+		RigidBodyComponent,		// 1
+		SpriteComponent,		// 2
+		AnimationComponent,		// 3
+		BoxColliderComponent,	// 4
+		ParentComponent,		// 5
+		EnemyTag,				// 6
+		StaticTag				// 7
+	> type;
+};
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef ENEMYTAG_H
+#define ENEMYTAG_H
+
+//marks entities that are enemies of the player. a tag has no data, it only sets a bit in the
+//entity's signature, filter on it with System::RequireComponent/ExcludeComponent or View().With
+struct EnemyTag {};
+
+#endif
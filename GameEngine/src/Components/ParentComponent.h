@@ -0,0 +1,26 @@
+#ifndef PARENTCOMPONENT_H
+#define PARENTCOMPONENT_H
+
+//only Entity, not ECS.h. with static component ids ECS.h includes this file through ComponentList.h
+#include "../ECS/Entity.h"
+#include <glm/glm.hpp>
+
+//attaches an entity to a parent entity. the entity's TransformComponent becomes its world
+//transform and is worked out by the HierarchySystem from the parent's transform and the local
+//transform below, so a turret follows its tank without being moved by hand.
+//changing parent should go through Registry::Patch so the hierarchy is reordered.
+struct ParentComponent {
+	Entity parent;
+	//transform relative to the parent, rotation in degrees like TransformComponent
+	glm::vec2 localPosition;
+	glm::vec2 localScale;
+	double localRotation;
+
+	ParentComponent(Entity parent = Entity(-1), glm::vec2 localPosition = glm::vec2(0, 0), glm::vec2 localScale = glm::vec2(1, 1), double localRotation = 0.0) : parent(parent) {
+		this->localPosition = localPosition;
+		this->localScale = localScale;
+		this->localRotation = localRotation;
+	}
+};
+
+#endif
@@ -1,5 +1,6 @@
 #ifndef SPRITECOMPONENT_H
 #define SPRITECOMPONENT_H
+#include <SDL.h>
 #include <string>
 
 struct SpriteComponent {
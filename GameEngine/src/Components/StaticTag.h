@@ -0,0 +1,7 @@
+#ifndef STATICTAG_H
+#define STATICTAG_H
+
+//marks entities that never move, like the tiles of the map. a tag has no data, see EnemyTag
+struct StaticTag {};
+
+#endif
@@ -4,7 +4,9 @@
 
 //TODO: implement ECS classes
 //initialize nextId int, within IComopnent
-int IComponent::nextId = 0;
+std::atomic<int> IComponent::nextId(0);
+std::atomic<int> IResource::nextId(0);
+std::atomic<int> Registry::nextRegistryId(0);
 
 ////////////////////////////////////////////////////////////////////////////////
 //Entity implementations
@@ -13,6 +15,14 @@ int Entity::GetId() const {
 	return id; //encapsulation of member id of entity class.
 }
 
+unsigned int Entity::GetGeneration() const {
+	return generation;
+}
+
+bool Entity::IsAlive() const {
+	return registry->IsAlive(*this);
+}
+
 void Entity::Kill() {
 	registry->KillEntity(*this);
 }
@@ -21,18 +31,37 @@ void Entity::Kill() {
 //System Implementations
 ////////////////////////////////////////////////////////////////////////////////
 void System::AddEntityToSystem(Entity entity) {
+	const int entityId = entity.GetId();
+	if (entityId >= static_cast<int>(entityIdToIndex.size())) {
+		entityIdToIndex.resize(std::max(static_cast<size_t>(entityId) + 1, entityIdToIndex.size() * 2), -1);
+	}
+	if (entityIdToIndex[entityId] != -1) {
+		return;
+	}
+	entityIdToIndex[entityId] = static_cast<int>(entities.size());
 	entities.push_back(entity);
 }
 
-//iterates through entities in system then deletes entities that matches given entity
+//looks up the entity's slot, moves the last entity into it and shrinks the vector
 void System::RemoveEntityFromSystem(Entity entity) {
-	entities.erase(std::remove_if(entities.begin(), entities.end(), 
-		[&entity](Entity other) {
-			return entity == other;//creates lambda/anonymous function
-		}), entities.end());
+	if (!HasEntity(entity)) {
+		return;
+	}
+	const int entityId = entity.GetId();
+	const int indexOfRemoved = entityIdToIndex[entityId];
+	const Entity last = entities.back();
+	entities[indexOfRemoved] = last;
+	entityIdToIndex[last.GetId()] = indexOfRemoved;
+	entities.pop_back();
+	entityIdToIndex[entityId] = -1;
+}
+
+bool System::HasEntity(Entity entity) const {
+	const int entityId = entity.GetId();
+	return entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != -1;
 }
 
-std::vector<Entity> System::GetSystemEntities() const {
+const std::vector<Entity>& System::GetSystemEntities() const {
 	return entities;
 }
 
@@ -40,6 +69,384 @@ const Signature& System::GetComponentSignature() const {
 	return componentSignature;
 }
 
+bool System::ConflictsWith(const System& other) const {
+	//a write conflicts with any access from the other system, two reads never conflict
+	//resources are checked the same way in their own id space
+	return writeSignature.Intersects(other.readSignature) || writeSignature.Intersects(other.writeSignature)
+		|| other.writeSignature.Intersects(readSignature)
+		|| resourceWriteSignature.Intersects(other.resourceReadSignature) || resourceWriteSignature.Intersects(other.resourceWriteSignature)
+		|| other.resourceWriteSignature.Intersects(resourceReadSignature);
+}
+
+int GetParallelGrainSize(ParallelMode mode, int grainSize, int numEntities, const ThreadPool* threadPool) {
+	if (grainSize > 0) {
+		return grainSize;
+	}
+	if (mode == PARALLEL_DETERMINISTIC) {
+		return PARALLEL_DETERMINISTIC_GRAIN;
+	}
+	//enough chunks for every thread to steal from, but never so small the tasks cost more than the work
+	const int numThreads = threadPool ? static_cast<int>(threadPool->GetNumThreads()) : 1;
+	const int targetChunks = numThreads * PARALLEL_CHUNKS_PER_THREAD;
+	return std::max(PARALLEL_MIN_GRAIN, (numEntities + targetChunks - 1) / targetChunks);
+}
+
+int System::GetParallelChunkCount(ParallelMode mode, int grainSize) const {
+	const int numEntities = static_cast<int>(entities.size());
+	const int grain = GetParallelGrainSize(mode, grainSize, numEntities, GetThreadPool());
+	return (numEntities + grain - 1) / grain;
+}
+
+unsigned int System::BeginChangeTracking() {
+	//writes stamp the registry's current tick. advancing it here makes every write from now on
+	//newer than the tick handed out now, even writes made later in this same frame
+	const unsigned int sinceTick = lastChangeTick;
+	lastChangeTick = registry->AdvanceChangeTick();
+	return sinceTick;
+}
+
+ThreadPool* System::GetThreadPool() const {
+	return registry ? registry->GetThreadPool() : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//CommandBuffer Implementations
+////////////////////////////////////////////////////////////////////////////////
+//placeholders use ids below -1, so they never match a real entity or an unset id
+static int PlaceholderIdToIndex(int entityId) {
+	return -2 - entityId;
+}
+
+CommandBuffer::~CommandBuffer() {
+	Clear();
+}
+
+Entity CommandBuffer::CreateEntity() {
+	Entity placeholder(PlaceholderIdToIndex(numCreatedEntities++));
+	placeholder.registry = nullptr;
+	AllocateCommand(COMMAND_CREATE, placeholder, 0, 1);
+	return placeholder;
+}
+
+void CommandBuffer::KillEntity(Entity entity) {
+	AllocateCommand(COMMAND_KILL, entity, 0, 1);
+}
+
+CommandBuffer::Command* CommandBuffer::AllocateCommand(CommandType type, Entity entity, size_t payloadSize, size_t payloadAlignment) {
+	//the payload goes right after the command, padded to its alignment
+	const size_t size = sizeof(Command) + payloadAlignment - 1 + payloadSize;
+	const size_t commandAlignment = alignof(Command);
+
+	//move on to the next block when the command does not fit, blocks from earlier frames are reused
+	while (true)
+	{
+		if (currentBlock == blocks.size())
+		{
+			Block block;
+			block.capacity = std::max(BLOCK_SIZE, size + commandAlignment);
+			block.data = std::make_unique<unsigned char[]>(block.capacity);
+			block.used = 0;
+			blocks.push_back(std::move(block));
+		}
+		Block& block = blocks[currentBlock];
+		const size_t offset = (block.used + commandAlignment - 1) / commandAlignment * commandAlignment;
+		if (offset + size <= block.capacity)
+		{
+			unsigned char* address = block.data.get() + offset;
+			const uintptr_t payloadAddress = reinterpret_cast<uintptr_t>(address + sizeof(Command));
+			unsigned char* payload = address + sizeof(Command) + ((payloadAlignment - payloadAddress % payloadAlignment) % payloadAlignment);
+
+			block.used = offset + size;
+			numCommands++;
+			return new (address) Command{ type, entity, nullptr, nullptr, payload, block.used };
+		}
+		//a reused block too small for a large command is skipped and stays empty this frame
+		currentBlock++;
+	}
+}
+
+Entity CommandBuffer::Resolve(Entity entity) const {
+	if (entity.GetId() < -1)
+	{
+		return createdEntities[PlaceholderIdToIndex(entity.GetId())];
+	}
+	return entity;
+}
+
+void CommandBuffer::Playback(Registry& registry) {
+	createdEntities.clear();
+	createdEntities.reserve(numCreatedEntities);
+
+	for (size_t blockIndex = 0; blockIndex <= currentBlock && blockIndex < blocks.size(); blockIndex++)
+	{
+		Block& block = blocks[blockIndex];
+		size_t offset = 0;
+		while (offset < block.used)
+		{
+			offset = (offset + alignof(Command) - 1) / alignof(Command) * alignof(Command);
+			Command* command = reinterpret_cast<Command*>(block.data.get() + offset);
+			switch (command->type)
+			{
+				case COMMAND_CREATE:
+					createdEntities.push_back(registry.CreateEntity());
+					break;
+				case COMMAND_KILL:
+					registry.KillEntity(Resolve(command->entity));
+					break;
+				case COMMAND_ADD:
+				case COMMAND_REMOVE:
+				case COMMAND_CHANGE:
+				{
+					//the entity may have been killed and its id reused since the command was recorded
+					const Entity entity = Resolve(command->entity);
+					if (registry.IsAlive(entity))
+					{
+						command->apply(registry, entity, command->payload);
+					}
+					break;
+				}
+			}
+			offset = command->nextOffset;
+		}
+	}
+	Clear();
+}
+
+void CommandBuffer::Clear() {
+	for (size_t blockIndex = 0; blockIndex <= currentBlock && blockIndex < blocks.size(); blockIndex++)
+	{
+		Block& block = blocks[blockIndex];
+		size_t offset = 0;
+		while (offset < block.used)
+		{
+			offset = (offset + alignof(Command) - 1) / alignof(Command) * alignof(Command);
+			Command* command = reinterpret_cast<Command*>(block.data.get() + offset);
+			if (command->destroy)
+			{
+				command->destroy(command->payload);
+			}
+			offset = command->nextOffset;
+			command->~Command();
+		}
+		block.used = 0;
+	}
+	currentBlock = 0;
+	numCommands = 0;
+	numCreatedEntities = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//Archetype Implementations
+////////////////////////////////////////////////////////////////////////////////
+Archetype::Archetype(const Signature& signature, const std::vector<ComponentInfo>& componentInfos)
+	: signature(signature), componentInfos(componentInfos) {
+	columnOffsets.resize(MAX_COMPONENTS, -1);
+	tickOffsets.resize(MAX_COMPONENTS, -1);
+	this->componentInfos.resize(MAX_COMPONENTS);
+
+	//size of one row (entity id + one of each component and its change tick)
+	size_t rowSize = sizeof(int);
+	for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++) {
+		//tags are part of the signature but have no column
+		if (signature.test(componentId) && this->componentInfos[componentId].size) {
+			componentIds.push_back(componentId);
+			rowSize += this->componentInfos[componentId].size + sizeof(unsigned int);
+		}
+	}
+
+	//lay out the columns, dropping rows until the alignment padding fits in the chunk
+	capacity = static_cast<int>(CHUNK_SIZE / rowSize);
+	while (capacity > 0) {
+		size_t offset = sizeof(int) * capacity;
+		for (int componentId : componentIds) {
+			const ComponentInfo& info = this->componentInfos[componentId];
+			offset = (offset + info.alignment - 1) / info.alignment * info.alignment;
+			columnOffsets[componentId] = static_cast<int>(offset);
+			offset += info.size * capacity;
+			offset = (offset + alignof(unsigned int) - 1) / alignof(unsigned int) * alignof(unsigned int);
+			tickOffsets[componentId] = static_cast<int>(offset);
+			offset += sizeof(unsigned int) * capacity;
+		}
+		if (offset <= CHUNK_SIZE) {
+			break;
+		}
+		capacity--;
+	}
+}
+
+Archetype::~Archetype() {
+	for (auto& chunk : chunks) {
+		for (int componentId : componentIds) {
+			const ComponentInfo& info = componentInfos[componentId];
+			unsigned char* column = static_cast<unsigned char*>(GetColumn(*chunk, componentId));
+			for (int row = 0; row < chunk->count; row++) {
+				info.destroy(column + row * info.size);
+			}
+		}
+	}
+}
+
+void Archetype::AddRow(int entityId, int& chunkIndex, int& row) {
+	if (chunks.empty() || chunks.back()->count == capacity) {
+		chunks.push_back(std::make_unique<Chunk>());
+	}
+	chunkIndex = static_cast<int>(chunks.size()) - 1;
+	Chunk& chunk = *chunks.back();
+	row = chunk.count++;
+	GetEntityIds(chunk)[row] = entityId;
+}
+
+int Archetype::RemoveRow(int chunkIndex, int row) {
+	Chunk& lastChunk = *chunks.back();
+	const int lastChunkIndex = static_cast<int>(chunks.size()) - 1;
+	const int lastRow = lastChunk.count - 1;
+	int movedEntityId = -1;
+
+	//move the last row of the archetype into the hole so every chunk but the last stays full
+	if (chunkIndex != lastChunkIndex || row != lastRow) {
+		for (int componentId : componentIds) {
+			const ComponentInfo& info = componentInfos[componentId];
+			void* source = GetComponent(lastChunkIndex, lastRow, componentId);
+			info.moveConstruct(GetComponent(chunkIndex, row, componentId), source);
+			info.destroy(source);
+			GetChangeTick(chunkIndex, row, componentId) = GetChangeTick(lastChunkIndex, lastRow, componentId);
+		}
+		movedEntityId = GetEntityIds(lastChunk)[lastRow];
+		GetEntityIds(*chunks[chunkIndex])[row] = movedEntityId;
+	}
+
+	lastChunk.count--;
+	if (lastChunk.count == 0) {
+		chunks.pop_back();
+	}
+	return movedEntityId;
+}
+
+Archetype* ArchetypeStorage::GetOrCreateArchetype(const Signature& signature) {
+	if (signature.none()) {
+		return nullptr;
+	}
+	auto archetype = archetypeBySignature.find(signature);
+	if (archetype != archetypeBySignature.end()) {
+		return archetype->second;
+	}
+	archetypes.push_back(std::make_unique<Archetype>(signature, componentInfos));
+	archetypeBySignature.emplace(signature, archetypes.back().get());
+	return archetypes.back().get();
+}
+
+void ArchetypeStorage::MoveEntity(int entityId, Archetype* destination) {
+	EntityLocation& location = entityLocations[entityId];
+	Archetype* source = location.archetype;
+	EntityLocation newLocation;
+	newLocation.archetype = destination;
+
+	if (destination) {
+		destination->AddRow(entityId, newLocation.chunkIndex, newLocation.row);
+	}
+
+	if (source) {
+		//move the components both archetypes share and destroy the rest
+		for (int componentId : source->GetComponentIds()) {
+			const ComponentInfo& info = componentInfos[componentId];
+			void* component = source->GetComponent(location.chunkIndex, location.row, componentId);
+			if (destination && destination->GetSignature().test(componentId)) {
+				info.moveConstruct(destination->GetComponent(newLocation.chunkIndex, newLocation.row, componentId), component);
+				destination->GetChangeTick(newLocation.chunkIndex, newLocation.row, componentId) = source->GetChangeTick(location.chunkIndex, location.row, componentId);
+			}
+			info.destroy(component);
+		}
+		const int movedEntityId = source->RemoveRow(location.chunkIndex, location.row);
+		if (movedEntityId != -1) {
+			entityLocations[movedEntityId].chunkIndex = location.chunkIndex;
+			entityLocations[movedEntityId].row = location.row;
+		}
+	}
+
+	location = newLocation;
+}
+
+void ArchetypeStorage::RemoveComponent(int entityId, int componentId) {
+	Archetype* archetype = entityLocations[entityId].archetype;
+	if (!archetype || !archetype->GetSignature().test(componentId)) {
+		return;
+	}
+	Signature signature = archetype->GetSignature();
+	signature.set(componentId, false);
+	MoveEntity(entityId, GetOrCreateArchetype(signature));
+}
+
+void ArchetypeStorage::RemoveEntity(int entityId) {
+	if (entityId < static_cast<int>(entityLocations.size())) {
+		MoveEntity(entityId, nullptr);
+	}
+}
+
+void* ArchetypeStorage::GetComponent(int entityId, int componentId) const {
+	const EntityLocation& location = entityLocations[entityId];
+	return location.archetype->GetComponent(location.chunkIndex, location.row, componentId);
+}
+
+unsigned int& ArchetypeStorage::GetChangeTick(int entityId, int componentId) const {
+	const EntityLocation& location = entityLocations[entityId];
+	return location.archetype->GetChangeTick(location.chunkIndex, location.row, componentId);
+}
+
+void ArchetypeStorage::AddEntities(const int* entityIds, int count, const std::vector<ComponentPrototype>& prototypes, unsigned int changeTick) {
+	Signature signature;
+	for (const auto& prototype : prototypes) {
+		if (prototype.componentId >= static_cast<int>(componentInfos.size())) {
+			componentInfos.resize(prototype.componentId + 1);
+		}
+		if (!componentInfos[prototype.componentId].destroy) {
+			componentInfos[prototype.componentId] = prototype.info;
+		}
+		signature.set(prototype.componentId);
+	}
+	int maxEntityId = -1;
+	for (int i = 0; i < count; i++) {
+		maxEntityId = std::max(maxEntityId, entityIds[i]);
+	}
+	if (maxEntityId >= static_cast<int>(entityLocations.size())) {
+		entityLocations.resize(std::max(static_cast<size_t>(maxEntityId) + 1, entityLocations.size() * 2));
+	}
+	Archetype* archetype = GetOrCreateArchetype(signature);
+	if (!archetype) {
+		return;
+	}
+
+	//one chunk at a time: reserve the rows that fit in it, then fill each column of those rows with copies
+	for (int first = 0; first < count;) {
+		int chunkIndex, row;
+		archetype->AddRow(entityIds[first], chunkIndex, row);
+		Chunk& chunk = archetype->GetChunk(chunkIndex);
+		const int numRows = std::min(count - first, archetype->GetCapacity() - chunk.count + 1);
+		for (int i = 1; i < numRows; i++) {
+			int sameChunkIndex, nextRow;
+			archetype->AddRow(entityIds[first + i], sameChunkIndex, nextRow);
+		}
+		for (int i = 0; i < numRows; i++) {
+			EntityLocation& location = entityLocations[entityIds[first + i]];
+			location.archetype = archetype;
+			location.chunkIndex = chunkIndex;
+			location.row = row + i;
+		}
+
+		for (const auto& prototype : prototypes) {
+			//tags have no column
+			if (!prototype.info.size) {
+				continue;
+			}
+			unsigned char* column = static_cast<unsigned char*>(archetype->GetComponent(chunkIndex, row, prototype.componentId));
+			for (int i = 0; i < numRows; i++) {
+				prototype.info.copyConstruct(column + i * prototype.info.size, prototype.component);
+			}
+			std::fill_n(archetype->GetChangeTicks(chunk, prototype.componentId) + row, numRows, changeTick);
+		}
+		first += numRows;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //Registry Implementations
 ////////////////////////////////////////////////////////////////////////////////
@@ -47,33 +454,137 @@ const Signature& System::GetComponentSignature() const {
 //inserts 
 Entity Registry::CreateEntity() {
 	int entityId;
-	if (freeIds.empty()) {
-		entityId = numEntities++;//incremenet number of entities
+	if (firstFreeId == -1) {
+		entityId = static_cast<int>(entitySlots.size());
+		entitySlots.emplace_back();
 
-		// Make sure the entityComponentSignature vector can accomodate the new entity
+		// Make sure the entityComponentSignature vector can accomodate the new entity,
+		// growing geometrically so spawning one entity at a time stays amortized O(1)
 		if (entityId >= entityComponenetSignatures.size())
 		{
-			entityComponenetSignatures.resize(entityId + 1);
+			const size_t newSize = std::max(static_cast<size_t>(entityId) + 1, entityComponenetSignatures.size() * 2);
+			entityComponenetSignatures.resize(newSize);
+			entityMembershipSignatures.resize(newSize);
 		}
 	}
 	else
 	{
-		//Reuse an id from previously used entites
-		entityId = freeIds.front();
-		freeIds.pop_front();
+		//Reuse an id from previously used entites, its generation was bumped when it was freed
+		entityId = firstFreeId;
+		firstFreeId = entitySlots[entityId].nextFreeId;
+		entitySlots[entityId].nextFreeId = -1;
 	}
 	//create new entity with new id and add enitiy to vector to be added.
-	Entity entity(entityId);
+	Entity entity(entityId, entitySlots[entityId].generation);
 	entity.registry = this;
-	entitiesToBeAdded.insert(entity);
-
-	Logger::Log("Entity Created with id = " + std::to_string(entityId));
+	entitySlots[entityId].isAddPending = true;
+	entitiesToBeAdded.push_back(entity);
 
+	//not logged, formatting a message and taking the logger's lock costs more than creating the entity
 	return entity;
 }
 
+std::vector<Entity> Registry::CreateEntities(int count) {
+	std::vector<Entity> entities;
+	//a negative count would turn into a huge size for reserve
+	if (count <= 0)
+	{
+		return entities;
+	}
+	entities.reserve(count);
+
+	//recycled ids first, their slots and signatures already exist
+	while (firstFreeId != -1 && static_cast<int>(entities.size()) < count)
+	{
+		const int entityId = firstFreeId;
+		firstFreeId = entitySlots[entityId].nextFreeId;
+		entitySlots[entityId].nextFreeId = -1;
+		entities.emplace_back(entityId, entitySlots[entityId].generation);
+	}
+
+	//the rest get new ids at the end, every per entity vector is grown once
+	const int firstNewId = static_cast<int>(entitySlots.size());
+	const int numNewIds = count - static_cast<int>(entities.size());
+	if (numNewIds > 0)
+	{
+		entitySlots.resize(firstNewId + numNewIds);
+		if (entitySlots.size() > entityComponenetSignatures.size())
+		{
+			entityComponenetSignatures.resize(entitySlots.size());
+			entityMembershipSignatures.resize(entitySlots.size());
+		}
+		for (int entityId = firstNewId; entityId < firstNewId + numNewIds; entityId++)
+		{
+			entities.emplace_back(entityId, entitySlots[entityId].generation);
+		}
+	}
+
+	for (Entity& entity : entities)
+	{
+		entity.registry = this;
+		entitySlots[entity.GetId()].isAddPending = true;
+	}
+	entitiesToBeAdded.insert(entitiesToBeAdded.end(), entities.begin(), entities.end());
+
+	Logger::Log(std::to_string(count) + " entities created");
+
+	return entities;
+}
+
+std::vector<Entity> Registry::Instantiate(const Prefab& prefab, int count) {
+	std::vector<Entity> entities = CreateEntities(count);
+	if (entities.empty())
+	{
+		return entities;
+	}
+
+	if (storageMode == STORAGE_CHUNKS)
+	{
+		std::vector<int> entityIds;
+		std::vector<ComponentPrototype> prototypes;
+		entityIds.reserve(entities.size());
+		for (const Entity& entity : entities)
+		{
+			entityIds.push_back(entity.GetId());
+		}
+		for (const auto& component : prefab.components)
+		{
+			prototypes.push_back(component.prototype);
+		}
+		archetypeStorage.AddEntities(entityIds.data(), count, prototypes, GetChangeTick());
+	}
+	else
+	{
+		for (const auto& component : prefab.components)
+		{
+			component.addToPool(*this, entities, component.prototype.component);
+		}
+	}
+
+	//the whole signature is set at once, the new entities join their systems when Update adds them
+	for (const Entity& entity : entities)
+	{
+		entityComponenetSignatures[entity.GetId()] = prefab.signature;
+	}
+	for (const auto& component : prefab.components)
+	{
+		for (const Entity& entity : entities)
+		{
+			QueueComponentEvent(component.prototype.componentId, EVENT_ADDED, entity);
+		}
+	}
+
+	Logger::Log(std::to_string(count) + " entities instantiated from a prefab with " + std::to_string(prefab.components.size()) + " components");
+	return entities;
+}
+
 void Registry::KillEntity(Entity entity) {
-	entitiesToBeKilled.insert(entity);
+	//a stale handle must not kill the entity that now owns the id
+	if (IsAlive(entity) && !entitySlots[entity.GetId()].isKillPending)
+	{
+		entitySlots[entity.GetId()].isKillPending = true;
+		entitiesToBeKilled.push_back(entity);
+	}
 }
 
 //adds entity to a system that is interested in the entity
@@ -85,13 +596,11 @@ void Registry::AddEntityToSystems(Entity entity) {
 	
 	// loop all the systems
 	for (auto& system: systems) {
-		const auto& systemComponentSignature = system.second->GetComponentSignature();
-		
-		//preform AND bitwise between entity & systen component signature.
+		//preform AND bitwise between entity & systen component signature, one word at a time.
 		//results in removing any bits that are not included in systemComponentSignature
-		//iff the result of AND bitwise comparison matches the system component signature then 
-		//logic will return true.
-		bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+		//iff the result of AND bitwise comparison matches the system component signature, and
+		//the entity has none of the components the system excludes, then logic will return true.
+		bool isInterested = system.second->Matches(entityComponentSignature);
 
 		if (isInterested) 
 		{
@@ -99,33 +608,267 @@ void Registry::AddEntityToSystems(Entity entity) {
 			system.second->AddEntityToSystem(entity);
 		}
 	}
-
+	entityMembershipSignatures[entityId] = entityComponentSignature;
 }
 
 void Registry::RemoveEntityFromSystems(Entity entity) {
-	for (auto system : systems) {
-		system.second->RemoveEntityFromSystem(entity);
+	auto& entityMembershipSignature = entityMembershipSignatures[entity.GetId()];
+
+	//only systems whose signature matched the entity can hold it
+	for (auto& system : systems) {
+		if (system.second->Matches(entityMembershipSignature))
+		{
+			system.second->RemoveEntityFromSystem(entity);
+		}
 	}
+	entityMembershipSignature.reset();
 	Logger::Log("Entity [" + std::to_string(entity.GetId()) + "] Has been Removed from systems");
 }
 
+void Registry::AddEntitiesToSystems(const std::vector<Entity>& entities) {
+	//system by system, so one system's entity list and lookup table stay in cache for the whole batch
+	for (auto& system : systems) {
+		for (const Entity& entity : entities)
+		{
+			if (system.second->Matches(entityComponenetSignatures[entity.GetId()]))
+			{
+				system.second->AddEntityToSystem(entity);
+			}
+		}
+	}
+	for (const Entity& entity : entities)
+	{
+		entityMembershipSignatures[entity.GetId()] = entityComponenetSignatures[entity.GetId()];
+	}
+}
+
+void Registry::RemoveEntitiesFromSystems(const std::vector<Entity>& entities) {
+	for (auto& system : systems) {
+		for (const Entity& entity : entities)
+		{
+			if (system.second->Matches(entityMembershipSignatures[entity.GetId()]))
+			{
+				system.second->RemoveEntityFromSystem(entity);
+			}
+		}
+	}
+	for (const Entity& entity : entities)
+	{
+		entityMembershipSignatures[entity.GetId()].reset();
+	}
+}
+
+void Registry::UpdateEntityInSystems(Entity entity) {
+	const auto entityId = entity.GetId();
+	const auto& entityComponentSignature = entityComponenetSignatures[entityId];
+	auto& entityMembershipSignature = entityMembershipSignatures[entityId];
+
+	//bits that were turned on or off since membership was last updated
+	const auto changedComponents = entityComponentSignature ^ entityMembershipSignature;
+	if (changedComponents.none())
+	{
+		return;
+	}
+
+	for (auto& system : systems) {
+		//systems that do not require or exclude any of the changed components keep their answer
+		if (!changedComponents.Intersects(system.second->GetComponentSignature()) && !changedComponents.Intersects(system.second->GetExcludeSignature()))
+		{
+			continue;
+		}
+		if (system.second->Matches(entityComponentSignature))
+		{
+			system.second->AddEntityToSystem(entity);
+		}
+		else
+		{
+			system.second->RemoveEntityFromSystem(entity);
+		}
+	}
+	entityMembershipSignature = entityComponentSignature;
+}
+
+void Registry::MarkSignatureChanged(int entityId) {
+	EntitySlot& slot = entitySlots[entityId];
+	//entities waiting to be added get their membership from their whole signature when they are added
+	if (!slot.isSignatureChanged && !slot.isAddPending)
+	{
+		slot.isSignatureChanged = true;
+		entitiesWithChangedSignatures.push_back(entityId);
+	}
+}
+
+void Registry::AddObserver(int componentId, ComponentEvent event, std::function<void(Entity)> observer) {
+	if (componentId >= static_cast<int>(componentObservers.size()))
+	{
+		componentObservers.resize(componentId + 1);
+	}
+	componentObservers[componentId].observers[event].push_back(std::move(observer));
+}
+
+void Registry::QueueComponentEvent(int componentId, ComponentEvent event, Entity entity) {
+	if (componentId < static_cast<int>(componentObservers.size()) && !componentObservers[componentId].observers[event].empty())
+	{
+		componentObservers[componentId].pendingEntities[event].push_back(entity);
+	}
+}
+
+void Registry::NotifyObservers() {
+	std::vector<Entity> entities;
+	for (size_t componentId = 0; componentId < componentObservers.size(); componentId++)
+	{
+		for (int event = 0; event < NUM_COMPONENT_EVENTS; event++)
+		{
+			if (componentObservers[componentId].pendingEntities[event].empty())
+			{
+				continue;
+			}
+			//take the queue first, events caused by the observers themselves are reported next update
+			entities.clear();
+			entities.swap(componentObservers[componentId].pendingEntities[event]);
+			std::sort(entities.begin(), entities.end());
+			entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+
+			for (Entity entity : entities)
+			{
+				const bool hasComponent = IsAlive(entity) && entityComponenetSignatures[entity.GetId()].test(componentId);
+				if (hasComponent == (event == EVENT_REMOVED))
+				{
+					continue;
+				}
+				entity.registry = this;
+				//indexed, an observer may add more observers
+				for (size_t i = 0; i < componentObservers[componentId].observers[event].size(); i++)
+				{
+					componentObservers[componentId].observers[event][i](entity);
+				}
+			}
+		}
+	}
+}
+
+CommandBuffer& Registry::GetCommandBuffer() {
+	//each thread remembers its buffer for every registry it recorded into, so only the
+	//first call from a thread takes the lock
+	thread_local std::vector<std::pair<int, CommandBuffer*>> threadBuffers;
+	for (const auto& threadBuffer : threadBuffers)
+	{
+		if (threadBuffer.first == registryId)
+		{
+			return *threadBuffer.second;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(commandBuffersMutex);
+	commandBuffers.push_back(std::make_unique<CommandBuffer>());
+	threadBuffers.emplace_back(registryId, commandBuffers.back().get());
+	return *commandBuffers.back();
+}
+
+void Registry::PlaybackCommandBuffers() {
+	for (auto& commandBuffer : commandBuffers)
+	{
+		if (!commandBuffer->IsEmpty())
+		{
+			commandBuffer->Playback(*this);
+		}
+	}
+}
+
 void Registry::Update() {
+	//Make the changes systems recorded from worker threads, the entities they created
+	//and the components they added are picked up by the steps below in this same update
+	PlaybackCommandBuffers();
+
 	//Add the entities that are waiting to be created to the active Systems
-	for (auto entity : entitiesToBeAdded)
+	if (!entitiesToBeAdded.empty())
+	{
+		AddEntitiesToSystems(entitiesToBeAdded);
+		for (const Entity& entity : entitiesToBeAdded)
+		{
+			entitySlots[entity.GetId()].isAddPending = false;
+		}
+		entitiesToBeAdded.clear();
+	}
+
+	//Re-evaluate system membership of live entities that added or removed components.
+	//each entity is handled once per update no matter how many components it changed.
+	for (int entityId : entitiesWithChangedSignatures)
 	{
-		AddEntityToSystems(entity);
+		EntitySlot& slot = entitySlots[entityId];
+		slot.isSignatureChanged = false;
+
+		Entity entity(entityId, slot.generation);
+		entity.registry = this;
+		UpdateEntityInSystems(entity);
+	}
+	entitiesWithChangedSignatures.clear();
+
+	KillPendingEntities();
+
+	//every change of this update is done, let the observers catch up
+	NotifyObservers();
+}
+
+void Registry::KillPendingEntities() {
+	//Remove the entities that are waiting to be killed from active systems
+	if (entitiesToBeKilled.empty())
+	{
+		return;
+	}
+	RemoveEntitiesFromSystems(entitiesToBeKilled);
+
+	//the killed entities lose all of their components, tell the observers of each one
+	for (size_t componentId = 0; componentId < componentObservers.size(); componentId++)
+	{
+		if (componentObservers[componentId].observers[EVENT_REMOVED].empty())
+		{
+			continue;
+		}
+		for (const Entity& entity : entitiesToBeKilled)
+		{
+			if (entityComponenetSignatures[entity.GetId()].test(componentId))
+			{
+				QueueComponentEvent(static_cast<int>(componentId), EVENT_REMOVED, entity);
+			}
+		}
+	}
+
+	//Remove the entity's components so the pools/chunks stay packed, pool by pool
+	if (storageMode == STORAGE_CHUNKS)
+	{
+		for (const Entity& entity : entitiesToBeKilled)
+		{
+			archetypeStorage.RemoveEntity(entity.GetId());
+		}
+	}
+	else
+	{
+		for (auto& pool : componentPools)
+		{
+			if (pool)
+			{
+				for (const Entity& entity : entitiesToBeKilled)
+				{
+					pool->RemoveEntityFromPool(entity.GetId());
+				}
+			}
+		}
 	}
-	entitiesToBeAdded.clear();
 
-	//TODO: Remove the entities that are waiting to be killed from active systems
-	for (auto entity : entitiesToBeKilled)
+	for (const Entity& entity : entitiesToBeKilled)
 	{
-		RemoveEntityFromSystems(entity);
 		entityComponenetSignatures[entity.GetId()].reset();
 
-		//Make the entity ID is available to be used
-		freeIds.push_back(entity.GetId());
+		//Make the entity ID is available to be used. bumping the generation invalidates every
+		//copy of the killed entity, then the id is pushed on the front of the free list
+		EntitySlot& slot = entitySlots[entity.GetId()];
+		slot.generation++;
+		slot.isKillPending = false;
+		slot.nextFreeId = firstFreeId;
+		firstFreeId = entity.GetId();
 	}
+	Logger::Log(std::to_string(entitiesToBeKilled.size()) + " entities have been removed from systems");
 	entitiesToBeKilled.clear();
 }
 
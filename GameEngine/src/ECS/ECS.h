@@ -1,77 +1,265 @@
 #ifndef ECS_H
 #define ECS_H
 #include "../Logger/Logger.h"
-#include <bitset>
+#include "../ThreadPool/ThreadPool.h"
+#include "Entity.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <functional>
+#include <atomic>
 #include <vector>
 #include <unordered_map>
-#include <typeIndex>
-#include <set>
+#include <typeindex>
 #include <memory>
 #include <string>
-#include <deque>
+#include <tuple>
+#include <utility>
+#include <new>
+#include <algorithm>
+#include <mutex>
 /////////////////////////////////////////////////////////////////////////////
 // S I G N A T U R E
 /////////////////////////////////////////////////////////////////////////////
 //create signature datatype using bitset to track which components an enitiy has
 //and keeps track of which enities a system is interested in.
+//
+//the number of component types defaults to 32, which fits the signature in
+//a single 32 bit word. define ECS_MAX_COMPONENTS as 64, 128 or 256 in the
+//project's preprocessor definitions for a larger component vocabulary, the
+//signature then becomes an array of 64 bit words compared word by word, or
+//16 bytes at a time with SSE2 when the compiler targets it.
 /////////////////////////////////////////////////////////////////////////////
-const unsigned int MAX_COMPONENTS = 32;
-typedef std::bitset<MAX_COMPONENTS> Signature;
-/////////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////////
-/// E N T I T Y
-/////////////////////////////////////////////////////////////////////////////
-/// entities are objects that only give an identifier to a game object
-/////////////////////////////////////////////////////////////////////////////
+#ifndef ECS_MAX_COMPONENTS
+#define ECS_MAX_COMPONENTS 32
+#endif
+const unsigned int MAX_COMPONENTS = ECS_MAX_COMPONENTS;
+static_assert(MAX_COMPONENTS == 32 || MAX_COMPONENTS == 64 || MAX_COMPONENTS == 128 || MAX_COMPONENTS == 256,
+	"ECS_MAX_COMPONENTS must be 32, 64, 128 or 256");
 
-class Registry;//forward declaration
+#if (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ECS_SIGNATURE_SSE2
+#include <emmintrin.h>
+#endif
 
-class Entity {
+class Signature {
 	public:
-		Entity(int id) : id(id) {}; //using initializer list to initialized id
-		Entity(const Entity& entity) = default; //overloaded constructor using default build.
-		int GetId() const;//getter method.
-		void Kill();//kills entity, removes from systems, and reallocates id to be reused
-
-		//operator overloading to define the meaning of creating an entities based on another
-		Entity& operator = (const Entity& other) = default;
-		//operator overloading to define the meaning of comparing two entities with ==
-		bool operator == (const Entity& other) const {return id == other.id;}
-		//operator overloaded to define the meaning of comparing two entities with !=
-		bool operator != (const Entity& other) const {return id != other.id;}
-		bool operator >(const Entity& other) const { return id > other.id; }
-		bool operator <(const Entity& other) const { return id < other.id; }
-
-		// Hold a pointer to the entity's owner registry 
-		Registry* registry;
+		//a 32 component signature is one 32 bit word, wider signatures use 64 bit words
+		typedef std::conditional<MAX_COMPONENTS <= 32, uint32_t, uint64_t>::type Word;
+		static const unsigned int BITS_PER_WORD = sizeof(Word) * 8;
+		static const unsigned int NUM_WORDS = MAX_COMPONENTS / BITS_PER_WORD;
+
+		//same names as std::bitset so signatures read the same as before. std::bitset threw on a bit past
+		//the end, ids are checked when they are handed out instead, see CheckTypeId
+		Signature& set(size_t bit, bool value = true) {
+			assert(bit < MAX_COMPONENTS);
+			const Word mask = Word(1) << (bit % BITS_PER_WORD);
+			words[bit / BITS_PER_WORD] = value ? (words[bit / BITS_PER_WORD] | mask) : (words[bit / BITS_PER_WORD] & ~mask);
+			return *this;
+		}
+		bool test(size_t bit) const {
+			assert(bit < MAX_COMPONENTS);
+			return (words[bit / BITS_PER_WORD] >> (bit % BITS_PER_WORD)) & 1;
+		}
+		Signature& reset() {
+			for (Word& word : words) { word = 0; }
+			return *this;
+		}
+		bool none() const {
+			Word combined = 0;
+			for (Word word : words) { combined |= word; }
+			return combined == 0;
+		}
+		bool any() const { return !none(); }
+
+		//true when every bit set in other is also set here. same answer as (*this & other) == other
+		//but without building a temporary signature. this is the entity vs system matching test.
+		bool Contains(const Signature& other) const {
+#ifdef ECS_SIGNATURE_SSE2
+			if (NUM_WORDS * sizeof(Word) >= 16) {
+				for (unsigned int i = 0; i < NUM_WORDS; i += 16 / sizeof(Word)) {
+					const __m128i mine = _mm_load_si128(reinterpret_cast<const __m128i*>(&words[i]));
+					const __m128i theirs = _mm_load_si128(reinterpret_cast<const __m128i*>(&other.words[i]));
+					const __m128i equal = _mm_cmpeq_epi8(_mm_and_si128(mine, theirs), theirs);
+					if (_mm_movemask_epi8(equal) != 0xFFFF) {
+						return false;
+					}
+				}
+				return true;
+			}
+#endif
+			Word missing = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				missing |= other.words[i] & ~words[i];
+			}
+			return missing == 0;
+		}
+		//true when the signatures share at least one bit
+		bool Intersects(const Signature& other) const {
+			Word shared = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) {
+				shared |= words[i] & other.words[i];
+			}
+			return shared != 0;
+		}
+
+		Signature operator &(const Signature& other) const {
+			Signature result;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) { result.words[i] = words[i] & other.words[i]; }
+			return result;
+		}
+		Signature operator |(const Signature& other) const {
+			Signature result;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) { result.words[i] = words[i] | other.words[i]; }
+			return result;
+		}
+		Signature operator ^(const Signature& other) const {
+			Signature result;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) { result.words[i] = words[i] ^ other.words[i]; }
+			return result;
+		}
+		bool operator ==(const Signature& other) const {
+			Word different = 0;
+			for (unsigned int i = 0; i < NUM_WORDS; i++) { different |= words[i] ^ other.words[i]; }
+			return different == 0;
+		}
+		bool operator !=(const Signature& other) const { return !(*this == other); }
+
+		size_t Hash() const {
+			size_t hash = 0;
+			for (Word word : words) {
+				hash ^= std::hash<Word>()(word) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			}
+			return hash;
+		}
 
-		// methods to control registry through the entity.
-		//surves no purpose beside making syntax easier when adding components to entities.
-		template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
-		template <typename TComponent> void RemoveComponent();
-		template <typename TComponent> bool HasComponent() const;
-		template <typename TComponent> TComponent& GetComponent() const;
 	private:
-		int id;
+		//wide signatures are 16 byte aligned for the SSE2 loads, the 32 component signature stays 4 bytes
+		alignas(NUM_WORDS * sizeof(Word) >= 16 ? 16 : sizeof(Word)) Word words[NUM_WORDS] = {};
 };
+
+//lets signatures key unordered containers, used to look up archetypes
+namespace std {
+	template <> struct hash<Signature> {
+		size_t operator ()(const Signature& signature) const { return signature.Hash(); }
+	};
+}
 /////////////////////////////////////////////////////////////////////////////
 // C O M P O N E N T
 /////////////////////////////////////////////////////////////////////////////
 //base structure for component class. Interface Component.
 struct IComponent {
 	protected://only usuable to inherited classes or part of class
-		static int nextId;
+		static std::atomic<int> nextId;
+};
+
+//A compile time list of component types
+template <typename ...TComponents>
+struct ComponentList {
+	static const int size = sizeof...(TComponents);
+};
+
+//position of TComponent in a ComponentList, -1 when the list does not contain it
+template <typename TComponent, typename TList>
+struct ComponentListIndex;
+
+template <typename TComponent>
+struct ComponentListIndex<TComponent, ComponentList<>> {
+	static constexpr int value = -1;
+};
+
+template <typename TComponent, typename TFirst, typename ...TRest>
+struct ComponentListIndex<TComponent, ComponentList<TFirst, TRest...>> {
+	static constexpr int next = ComponentListIndex<TComponent, ComponentList<TRest...>>::value;
+	static constexpr int value = std::is_same<TComponent, TFirst>::value ? 0 : (next == -1 ? -1 : next + 1);
+};
+
+//The project's compile time component list, empty by default.
+//defining ECS_STATIC_COMPONENT_IDS pulls in Components/ComponentList.h, which
+//specializes this with every component type the game uses. components in the
+//list get their position as a constexpr id that never changes between runs.
+//the project leaves it undefined so the ECS does not depend on the game's
+//components, or on SDL through them.
+template <typename = void>
+struct RegisteredComponents {
+	typedef ComponentList<> type;
 };
+
+#ifdef ECS_STATIC_COMPONENT_IDS
+#include "../Components/ComponentList.h"
+#endif
+
+//Components without data members are tags, like EnemyTag. a tag only sets its bit in the
+//entity's signature, no pool or chunk column is made for it.
+template <typename TComponent>
+struct IsTagComponent : std::is_empty<typename std::remove_const<TComponent>::type> {};
+
+//component and resource ids index signatures and the archetype columns, which have room for MAX_COMPONENTS.
+//one more type would write past them, so the game stops with an error instead
+inline int CheckTypeId(int id, const char* kind) {
+	if (id >= static_cast<int>(MAX_COMPONENTS)) {
+		Logger::Err(std::string("ECS: more ") + kind + " types than ECS_MAX_COMPONENTS (" + std::to_string(MAX_COMPONENTS) + "), raise it in the preprocessor definitions");
+		std::abort();
+	}
+	return id;
+}
+
 //used to assign a unique ids to a component type. generic TComponent
 template <typename TComponent>
 class Component: public IComponent {
-	// Returns the unique id of the component<T>
 	public:
+	typedef typename RegisteredComponents<>::type StaticComponents;
+	static_assert(StaticComponents::size <= static_cast<int>(MAX_COMPONENTS), "more registered components than MAX_COMPONENTS");
+
+	//compile time id of the component, -1 when it is not in the registered list
+	static constexpr int staticId = ComponentListIndex<TComponent, StaticComponents>::value;
+
+	// Returns the unique id of the component<T>
+	// registered components return a constant, others are numbered on first use after the registered ones.
+	// const T shares the id of T, views use it for components they only read
 	static int GetId() {
-		static auto id = nextId++;
-		return id;
+		if constexpr (std::is_const<TComponent>::value) {
+			return Component<typename std::remove_const<TComponent>::type>::GetId();
+		}
+		else if constexpr (staticId != -1) {
+			return staticId;
+		}
+		else {
+			static auto id = CheckTypeId(StaticComponents::size + nextId++, "component");
+			return id;
+		}
 	}
 };
+/////////////////////////////////////////////////////////////////////////////
+// R E S O U R C E
+/////////////////////////////////////////////////////////////////////////////
+// resources are registry wide singletons, state there is only one of like
+// the frame time or the window size. they are not attached to entities, the
+// registry keeps one of each type in a vector indexed by the resource id so
+// looking one up is a single index. systems declare the resources they use
+// with RequireResource so the scheduler sees them as dependencies.
+/////////////////////////////////////////////////////////////////////////////
+struct IResource {
+	virtual ~IResource() = default;
+	protected:
+		static std::atomic<int> nextId;
+};
+
+//owns the resource object, also numbers the resource types the same way Component<T> numbers components
+template <typename TResource>
+class Resource : public IResource {
+	public:
+		template <typename ...TArgs>
+		Resource(TArgs&& ...args) : value(std::forward<TArgs>(args)...) {}
+		TResource value;
+
+		//resource ids share the signature type with components for scheduling, so there can be up to MAX_COMPONENTS of them
+		static int GetId() {
+			static auto id = CheckTypeId(nextId++, "resource");
+			return id;
+		}
+};
 	
 ///////////////////////////////////////////////////////////////////////////
 //  S Y S T E M
@@ -79,64 +267,566 @@ class Component: public IComponent {
 // The system processes entities that contain a specific signature
 ///////////////////////////////////////////////////////////////////////////
 
+//How a system uses a component it requires. the scheduler runs systems at the same
+//time only when neither of them writes a component the other one reads or writes.
+enum ComponentAccess {
+	ACCESS_READ,
+	ACCESS_WRITE
+};
+
+//How System::ParallelForEach and EntityView::ParallelEach split entities into chunks.
+//PARALLEL_FAST sizes the chunks from the number of threads so every thread gets a few of them.
+//PARALLEL_DETERMINISTIC uses chunk boundaries that only depend on the number of entities, so
+//per chunk results (partial sums and such) combine to the same bits on any machine.
+enum ParallelMode {
+	PARALLEL_FAST,
+	PARALLEL_DETERMINISTIC
+};
+
+//Chunks never get smaller than this, a few hundred entities worth of components
+//fit in a core's L1 cache and are enough work to pay for handing the chunk to a thread.
+const int PARALLEL_MIN_GRAIN = 256;
+//chunk size of PARALLEL_DETERMINISTIC when no grain size is given
+const int PARALLEL_DETERMINISTIC_GRAIN = 1024;
+//PARALLEL_FAST aims for this many chunks per thread so threads that finish early can steal the rest
+const int PARALLEL_CHUNKS_PER_THREAD = 4;
+
+//number of entities per chunk when numEntities are split over threadPool, grainSize > 0 overrides the mode
+int GetParallelGrainSize(ParallelMode mode, int grainSize, int numEntities, const ThreadPool* threadPool);
+
 class System {
 	public:
 		System() = default;
 		virtual ~System() = default;
 
+		//called by Registry::AddSystem once registry is set, on the thread adding the system.
+		//systems register their observers here, Update may run on a worker thread where that is not safe
+		virtual void OnAddedToRegistry() {}
+
+		//adding and removing are O(1), removing swaps the last entity into the removed slot
 		void AddEntityToSystem(Entity entity);
 		void RemoveEntityFromSystem(Entity entity);
-		std::vector<Entity> GetSystemEntities() const;
+		bool HasEntity(Entity entity) const;
+		const std::vector<Entity>& GetSystemEntities() const;
 		const Signature& GetComponentSignature() const; //returns reference of a Signature
 
 		//Define the component type T that entities must have to be considered by the system
 		//generic type, used for any type of component
-		template <typename T> void RequireComponent();
+		//access tells the scheduler if the system only reads the component or also writes it
+		template <typename T> void RequireComponent(ComponentAccess access = ACCESS_WRITE);
+		//Entities that have a component of type T are left out of the system, even if they have every required one
+		template <typename T> void ExcludeComponent();
+		const Signature& GetExcludeSignature() const { return excludeSignature; }
+		//true when an entity with the signature belongs in the system
+		bool Matches(const Signature& entitySignature) const {
+			return entitySignature.Contains(componentSignature) && !entitySignature.Intersects(excludeSignature);
+		}
+		//Declares a resource the system uses, see Registry::SetResource. it does not change which entities the system gets
+		template <typename T> void RequireResource(ComponentAccess access = ACCESS_READ);
+
+		const Signature& GetReadSignature() const	{ return readSignature; }
+		const Signature& GetWriteSignature() const	{ return writeSignature; }
+		//true when the systems can not safely run at the same time
+		bool ConflictsWith(const System& other) const;
+
+		//call at the start of an update that only wants to look at what changed. returns the tick to pass to
+		//View().Changed<T>(), every component written since the previous call is newer than it.
+		//Example: registry->View<const TransformComponent>().Changed<TransformComponent>(BeginChangeTracking())
+		unsigned int BeginChangeTracking();
+
+		//calls func(entity) for every entity of the system, chunks of entities run on the registry's thread pool.
+		//func may only touch the components of the entity it is given. without a thread pool it runs in place.
+		//grainSize overrides the number of entities per chunk, 0 lets the mode pick it.
+		//Example: ParallelForEach([](Entity entity) { entity.GetComponent<TransformComponent>().position.x += 1; });
+		template <typename TFunc> void ParallelForEach(TFunc func, ParallelMode mode = PARALLEL_FAST, int grainSize = 0) const;
+		//calls func(chunkIndex, first, last) once per chunk, first and last index into GetSystemEntities().
+		//chunks are numbered from 0 to GetParallelChunkCount() - 1, useful for keeping one result per chunk.
+		template <typename TFunc> void ParallelForEachChunk(TFunc func, ParallelMode mode = PARALLEL_FAST, int grainSize = 0) const;
+		int GetParallelChunkCount(ParallelMode mode = PARALLEL_FAST, int grainSize = 0) const;
+
+		// Hold a pointer to the system's owner registry, set when the system is added
+		Registry* registry = nullptr;
 
 	private:
 		Signature componentSignature;//which compents an entity must have for the system to consider the enitity
+		Signature excludeSignature;//components an entity must not have
+		Signature readSignature;//components the system reads
+		Signature writeSignature;//components the system writes
+		Signature resourceReadSignature;//resources the system reads, bits are resource ids
+		Signature resourceWriteSignature;//resources the system writes
 		std::vector<Entity> entities;//List of all entities that the system is interested in
+		//position of each entity in the entities vector, index = entity id. -1 when not in the system
+		std::vector<int> entityIdToIndex;
+		//registry change tick when BeginChangeTracking was last called
+		unsigned int lastChangeTick = 0;
+
+		ThreadPool* GetThreadPool() const;
 
 };
 
 //Implements the require component to decide what components matter to a given system
 template <typename TComponent>
-void System::RequireComponent() {
+void System::RequireComponent(ComponentAccess access) {
 	const auto componentId = Component<TComponent>::GetId();
 	componentSignature.set(componentId);
+	readSignature.set(componentId);
+	if (access == ACCESS_WRITE) {
+		writeSignature.set(componentId);
+	}
+}
+
+//only the presence of the component is looked at, so it does not count as reading it
+template <typename TComponent>
+void System::ExcludeComponent() {
+	excludeSignature.set(Component<TComponent>::GetId());
+}
+
+template <typename TResource>
+void System::RequireResource(ComponentAccess access) {
+	const auto resourceId = Resource<TResource>::GetId();
+	resourceReadSignature.set(resourceId);
+	if (access == ACCESS_WRITE) {
+		resourceWriteSignature.set(resourceId);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
 // P O O L
 //////////////////////////////////////////////////////////////////////////
-// A pool is just a vector {contigous data} of objects of type T
-// Pool is a wrapper for a vector of different types of components
+// A pool is a sparse set of components of type T
+// the components are packed together in a dense vector so iterating a
+// pool only touches components that are in use. a sparse vector maps an
+// entity id to the components index in the dense vector, and a second
+// dense vector maps the index back to the entity id that owns it.
 /////////////////////////////////////////////////////////////////////////
 
 class IPool {
 	public:
-		virtual ~IPool() = 0 {} //purely vitural type. Ipool used as interface to allow use in registry
+		virtual ~IPool() = default; //Ipool used as interface to allow use in registry
+		//removes the component that belongs to the entity, if it has one
+		virtual void RemoveEntityFromPool(int entityId) = 0;
 };
 
 template <typename T>
 class Pool : public IPool
 {
 	private:
+		//packed components, index = position in pool
 		std::vector<T> data;
+		//packed entity ids, index = position in pool. data[i] belongs to entity indexToEntityId[i]
+		std::vector<int> indexToEntityId;
+		//sparse lookup, index = entity id. -1 when the entity has no component in the pool
+		std::vector<int> entityIdToIndex;
+		//registry change tick of the last write to each component, index = position in pool
+		std::vector<unsigned int> changeTicks;
+
 	public:
-		Pool(int size = 100)	{ data.resize(size); }
-		~Pool() = default;
+		Pool(int capacity = 100) { 
+			data.reserve(capacity);
+			indexToEntityId.reserve(capacity);
+			changeTicks.reserve(capacity);
+		}
+		virtual ~Pool() = default;
+
 		bool isEmpty() const	{ return data.empty(); }
-		int GetSize() const		{ return data.size(); }
-		void Resize(int n)		{ data.resize(n); }
-		void Clear()			{ data.clear(); }
-		void Add(T object)		{ data.push_back(object); }
-		void Set(int index, T object) { data[index] = object; }
-		T& Get(int index)		{ return static_cast<T&>(data[index]); }
+		int GetSize() const		{ return static_cast<int>(data.size()); }
+
+		void Clear() {
+			data.clear();
+			indexToEntityId.clear();
+			entityIdToIndex.clear();
+			changeTicks.clear();
+		}
+
+		bool Has(int entityId) const {
+			return entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != -1;
+		}
+
+		//makes room for capacity components and for entity ids up to maxEntityId, so a batch of Set calls does not reallocate
+		void Reserve(int capacity, int maxEntityId) {
+			data.reserve(capacity);
+			indexToEntityId.reserve(capacity);
+			changeTicks.reserve(capacity);
+			if (maxEntityId >= static_cast<int>(entityIdToIndex.size())) {
+				entityIdToIndex.resize(maxEntityId + 1, -1);
+			}
+		}
+
+		//constructs the component from args at the end of the packed data, or replaces the one the entity already has.
+		//nothing is copied, so components that can only be moved work as well
+		template <typename ...TArgs>
+		T& Emplace(int entityId, TArgs&& ...args) {
+			if (Has(entityId)) {
+				T& component = data[entityIdToIndex[entityId]];
+				component = T(std::forward<TArgs>(args)...);
+				return component;
+			}
+			//the sparse vector at least doubles so a run of new ids does not reallocate on every add
+			if (entityId >= static_cast<int>(entityIdToIndex.size())) {
+				entityIdToIndex.resize(std::max(static_cast<size_t>(entityId) + 1, entityIdToIndex.size() * 2), -1);
+			}
+			entityIdToIndex[entityId] = static_cast<int>(data.size());
+			indexToEntityId.push_back(entityId);
+			changeTicks.push_back(0);
+			data.emplace_back(std::forward<TArgs>(args)...);
+			return data.back();
+		}
+
+		//adds the component to the end of the packed data, or replaces it if the entity already has one
+		void Set(int entityId, T&& object)		{ Emplace(entityId, std::move(object)); }
+		void Set(int entityId, const T& object)	{ Emplace(entityId, object); }
+
+		//moves the last component into the removed slot so the data stays packed
+		void Remove(int entityId) {
+			if (!Has(entityId)) {
+				return;
+			}
+			const int indexOfRemoved = entityIdToIndex[entityId];
+			const int indexOfLast = static_cast<int>(data.size()) - 1;
+			if (indexOfRemoved != indexOfLast) {
+				const int entityIdOfLast = indexToEntityId[indexOfLast];
+				data[indexOfRemoved] = std::move(data[indexOfLast]);
+				changeTicks[indexOfRemoved] = changeTicks[indexOfLast];
+				indexToEntityId[indexOfRemoved] = entityIdOfLast;
+				entityIdToIndex[entityIdOfLast] = indexOfRemoved;
+			}
+			data.pop_back();
+			indexToEntityId.pop_back();
+			changeTicks.pop_back();
+			entityIdToIndex[entityId] = -1;
+		}
+
+		void RemoveEntityFromPool(int entityId) override {
+			Remove(entityId);
+		}
+
+		T& Get(int entityId)	{ return static_cast<T&>(data[entityIdToIndex[entityId]]); }
+		//returns nullptr when the entity has no component in the pool
+		T* TryGet(int entityId)	{ return Has(entityId) ? &data[entityIdToIndex[entityId]] : nullptr; }
+		//position of the entity's component in the packed data, -1 when it has none
+		int IndexOf(int entityId) const	{ return entityId < static_cast<int>(entityIdToIndex.size()) ? entityIdToIndex[entityId] : -1; }
+		T& GetAt(int index)				{ return data[index]; }
+
+		//change tick of the entity's component, see Registry::MarkWritten
+		unsigned int& GetChangeTick(int entityId)	{ return changeTicks[entityIdToIndex[entityId]]; }
+		unsigned int& GetChangeTickAt(int index)	{ return changeTicks[index]; }
+
+		//packed access, used to iterate only the components that are alive
+		std::vector<T>& GetData()						{ return data; }
+		const std::vector<int>& GetEntityIds() const	{ return indexToEntityId; }
+
+		T& operator [](unsigned int entityId) {
+			return Get(entityId);
+		}
+};
+
+//////////////////////////////////////////////////////////////////////////
+// A R C H E T Y P E
+//////////////////////////////////////////////////////////////////////////
+// Optional storage mode for the registry. entities that have the same
+// signature live together in fixed size chunks, and each chunk has one
+// contiguous column per component type (structure of arrays). systems can
+// walk the columns of every matching chunk linearly.
+//////////////////////////////////////////////////////////////////////////
+
+//Selects how the registry stores components
+enum StorageMode {
+	STORAGE_POOLS,	//one sparse set pool per component type
+	STORAGE_CHUNKS	//archetype chunks with one column per component type
+};
+
+//size in bytes of the column data held by one chunk
+const unsigned int CHUNK_SIZE = 16 * 1024;
+const unsigned int CHUNK_ALIGNMENT = 64;
+
+//type erased description of a component type. lets chunks move and destroy
+//components without knowing their type at compile time.
+struct ComponentInfo {
+	size_t size = 0;
+	size_t alignment = 0;
+	void (*moveConstruct)(void* destination, void* source) = nullptr;
+	void (*destroy)(void* component) = nullptr;
+	//nullptr for components that can only be moved
+	void (*copyConstruct)(void* destination, const void* source) = nullptr;
+};
+
+template <typename TComponent>
+ComponentInfo MakeComponentInfo() {
+	static_assert(sizeof(TComponent) <= CHUNK_SIZE / 2, "component is too large to fit in an archetype chunk");
+	static_assert(alignof(TComponent) <= CHUNK_ALIGNMENT, "component alignment is larger than the chunk alignment");
+	ComponentInfo info;
+	//tags take no room, archetypes give them no column
+	info.size = IsTagComponent<TComponent>::value ? 0 : sizeof(TComponent);
+	info.alignment = alignof(TComponent);
+	info.moveConstruct = [](void* destination, void* source) {
+		new (destination) TComponent(std::move(*static_cast<TComponent*>(source)));
+	};
+	info.destroy = [](void* component) {
+		static_cast<TComponent*>(component)->~TComponent();
+	};
+	if constexpr (std::is_copy_constructible<TComponent>::value) {
+		info.copyConstruct = [](void* destination, const void* source) {
+			new (destination) TComponent(*static_cast<const TComponent*>(source));
+		};
+	}
+	return info;
+}
+
+//a component that is copied into every new row, see ArchetypeStorage::AddEntities
+struct ComponentPrototype {
+	int componentId;
+	ComponentInfo info;
+	const void* component;
+};
+
+//A chunk is a fixed block of memory holding the columns of an archetype.
+//the first column is the entity ids, then one column per component, each
+//followed by a column with the change tick of every component in it.
+struct Chunk {
+	int count = 0;
+	alignas(CHUNK_ALIGNMENT) unsigned char data[CHUNK_SIZE];
+};
+
+class Archetype {
+	public:
+		Archetype(const Signature& signature, const std::vector<ComponentInfo>& componentInfos);
+		~Archetype();
+
+		const Signature& GetSignature() const	{ return signature; }
+		int GetCapacity() const					{ return capacity; }
+		int GetNumChunks() const				{ return static_cast<int>(chunks.size()); }
+		Chunk& GetChunk(int chunkIndex)			{ return *chunks[chunkIndex]; }
+
+		int* GetEntityIds(Chunk& chunk) const { return reinterpret_cast<int*>(chunk.data); }
+
+		//returns the start of a component column, or nullptr if the archetype does not have the component
+		void* GetColumn(Chunk& chunk, int componentId) const {
+			const int offset = columnOffsets[componentId];
+			return offset < 0 ? nullptr : chunk.data + offset;
+		}
+		template <typename TComponent> TComponent* GetColumn(Chunk& chunk, int componentId) const {
+			return static_cast<TComponent*>(GetColumn(chunk, componentId));
+		}
+		void* GetComponent(int chunkIndex, int row, int componentId) const {
+			return chunks[chunkIndex]->data + columnOffsets[componentId] + row * componentInfos[componentId].size;
+		}
+		//change ticks of a component column, see Registry::MarkWritten
+		unsigned int* GetChangeTicks(Chunk& chunk, int componentId) const {
+			return reinterpret_cast<unsigned int*>(chunk.data + tickOffsets[componentId]);
+		}
+		unsigned int& GetChangeTick(int chunkIndex, int row, int componentId) const {
+			return GetChangeTicks(*chunks[chunkIndex], componentId)[row];
+		}
 
-		T& operator [](unsigned int index) {
-			return data[index];
+		//reserves a row at the end of the archetype for the entity. component memory is left unconstructed.
+		void AddRow(int entityId, int& chunkIndex, int& row);
+		//fills the hole at chunkIndex/row with the last row. the components in the hole must
+		//already be destroyed or moved out. returns the id of the entity that was moved or -1.
+		int RemoveRow(int chunkIndex, int row);
+
+		const std::vector<int>& GetComponentIds() const { return componentIds; }
+
+	private:
+		Signature signature;
+		//component ids that are part of the archetype in ascending order
+		std::vector<int> componentIds;
+		//byte offset of each column in a chunk, index = component id. -1 when not part of the archetype
+		std::vector<int> columnOffsets;
+		//byte offset of each change tick column, same indexing
+		std::vector<int> tickOffsets;
+		std::vector<ComponentInfo> componentInfos;
+		//number of rows that fit in one chunk
+		int capacity;
+		std::vector<std::unique_ptr<Chunk>> chunks;
+};
+
+//where an entity's components live when using STORAGE_CHUNKS
+struct EntityLocation {
+	Archetype* archetype = nullptr;
+	int chunkIndex = 0;
+	int row = 0;
+};
+
+class ArchetypeStorage {
+	public:
+		//constructs the component in the entity's chunk, moving the entity to the archetype that includes it
+		template <typename TComponent, typename ...TArgs> void AddComponent(int entityId, int componentId, TArgs&& ...args);
+		void RemoveComponent(int entityId, int componentId);
+		void RemoveEntity(int entityId);
+		void* GetComponent(int entityId, int componentId) const;
+		unsigned int& GetChangeTick(int entityId, int componentId) const;
+		const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const { return archetypes; }
+		//puts entities that have no components yet straight into the archetype of the prototypes, each
+		//component column of a chunk is filled with copies in one go. changeTick is stamped on every copy
+		void AddEntities(const int* entityIds, int count, const std::vector<ComponentPrototype>& prototypes, unsigned int changeTick);
+
+	private:
+		Archetype* GetOrCreateArchetype(const Signature& signature);
+		//moves the entity's row into the destination archetype (nullptr = no components).
+		//components the destination does not have are destroyed.
+		void MoveEntity(int entityId, Archetype* destination);
+
+		std::unordered_map<Signature, Archetype*> archetypeBySignature;
+		std::vector<std::unique_ptr<Archetype>> archetypes;
+		//index = entity id
+		std::vector<EntityLocation> entityLocations;
+		//index = component id
+		std::vector<ComponentInfo> componentInfos;
+};
+
+template <typename TComponent, typename ...TArgs>
+void ArchetypeStorage::AddComponent(int entityId, int componentId, TArgs&& ...args) {
+	if (componentId >= static_cast<int>(componentInfos.size())) {
+		componentInfos.resize(componentId + 1);
+	}
+	if (!componentInfos[componentId].destroy) {
+		componentInfos[componentId] = MakeComponentInfo<TComponent>();
+	}
+	if (entityId >= static_cast<int>(entityLocations.size())) {
+		entityLocations.resize(std::max(static_cast<size_t>(entityId) + 1, entityLocations.size() * 2));
+	}
+
+	EntityLocation& location = entityLocations[entityId];
+	Signature signature;
+	if (location.archetype) {
+		signature = location.archetype->GetSignature();
+	}
+
+	//a tag only moves the entity to the archetype that has its bit
+	if constexpr (IsTagComponent<TComponent>::value) {
+		if (!signature.test(componentId)) {
+			MoveEntity(entityId, GetOrCreateArchetype(signature.set(componentId)));
 		}
+		return;
+	}
+
+	//entity already has the component, replace it in place
+	if (signature.test(componentId)) {
+		TComponent* component = static_cast<TComponent*>(location.archetype->GetComponent(location.chunkIndex, location.row, componentId));
+		*component = TComponent(std::forward<TArgs>(args)...);
+		return;
+	}
+
+	signature.set(componentId);
+	MoveEntity(entityId, GetOrCreateArchetype(signature));
+	void* memory = location.archetype->GetComponent(location.chunkIndex, location.row, componentId);
+	new (memory) TComponent(std::forward<TArgs>(args)...);
+}
+
+template <typename ...TComponents> class EntityView;
+
+//////////////////////////////////////////////////////////////////////////
+// P R E F A B
+//////////////////////////////////////////////////////////////////////////
+// A prefab is a set of components that is made once and then copied onto
+// any number of new entities with Registry::Instantiate. the entities get
+// the prefab's whole signature at once: pools are filled with copies one
+// component type at a time, and in chunk storage the entities go straight
+// into their archetype instead of moving once per component added.
+//////////////////////////////////////////////////////////////////////////
+
+class Prefab {
+	public:
+		//sets the prefab's TComponent made from args, replacing the one it had. the component has to be copyable.
+		//Example: Prefab bullet; bullet.Add<TransformComponent>().Add<RigidBodyComponent>(glm::vec2(0.0, 200.0));
+		template <typename TComponent, typename ...TArgs> Prefab& Add(TArgs&& ...args);
+		template <typename TComponent> bool Has() const { return signature.test(Component<TComponent>::GetId()); }
+		//the component every instance starts with, the prefab must have it
+		template <typename TComponent> const TComponent& Get() const;
+		const Signature& GetSignature() const { return signature; }
+
+	private:
+		friend class Registry;
+
+		struct PrefabComponent {
+			ComponentPrototype prototype;
+			//keeps the prototype alive, copies of the prefab share it
+			std::shared_ptr<void> component;
+			//copies the prototype into the pool of every entity, see Registry::AddPrefabComponentToPool
+			void (*addToPool)(Registry& registry, const std::vector<Entity>& entities, const void* prototype);
+		};
+		Signature signature;
+		//in the order they were added
+		std::vector<PrefabComponent> components;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// C O M M A N D   B U F F E R
+//////////////////////////////////////////////////////////////////////////
+// Records structural changes (creating and killing entities, adding and
+// removing components) so they can be asked for from worker threads. each
+// thread records into its own buffer (Registry::GetCommandBuffer), so no
+// locks are taken while recording. commands and the components they carry
+// are written one after the other into large blocks of memory that are
+// kept and reused every frame. Registry::Update plays all buffers back in
+// one batch before it updates system membership.
+//////////////////////////////////////////////////////////////////////////
+
+class CommandBuffer {
+	public:
+		CommandBuffer() = default;
+		~CommandBuffer();
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator = (const CommandBuffer&) = delete;
+
+		//returns a placeholder for an entity that is created during playback. the placeholder
+		//can be passed to the other functions of this buffer, but not to the registry.
+		Entity CreateEntity();
+		void KillEntity(Entity entity);
+		//the component is constructed now and moved into storage during playback
+		template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+		template <typename TComponent> void RemoveComponent(Entity entity);
+		//runs the registry's OnChange observers of the component for the entity, see Registry::MarkChanged
+		template <typename TComponent> void MarkChanged(Entity entity);
+
+		bool IsEmpty() const { return numCommands == 0; }
+
+		//makes the recorded changes in the order they were recorded, then clears the buffer
+		void Playback(Registry& registry);
+		//throws away the recorded commands, the memory is kept for the next frame
+		void Clear();
+
+	private:
+		enum CommandType {
+			COMMAND_CREATE,
+			COMMAND_KILL,
+			COMMAND_ADD,
+			COMMAND_REMOVE,
+			COMMAND_CHANGE
+		};
+		struct Command {
+			CommandType type;
+			Entity entity;
+			//adds or removes the component. for COMMAND_ADD payload holds the component
+			void (*apply)(Registry& registry, Entity entity, void* payload);
+			void (*destroy)(void* payload);
+			void* payload;
+			//where the next command of the block starts
+			size_t nextOffset;
+		};
+		struct Block {
+			std::unique_ptr<unsigned char[]> data;
+			size_t capacity;
+			size_t used;
+		};
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+		//reserves a command followed by payloadSize bytes aligned to payloadAlignment, in the current block
+		Command* AllocateCommand(CommandType type, Entity entity, size_t payloadSize, size_t payloadAlignment);
+		//placeholders of entities created by this buffer become the entity made during playback
+		Entity Resolve(Entity entity) const;
+
+		template <typename TComponent> static void ApplyAdd(Registry& registry, Entity entity, void* payload);
+		template <typename TComponent> static void ApplyRemove(Registry& registry, Entity entity, void* payload);
+		template <typename TComponent> static void ApplyChange(Registry& registry, Entity entity, void* payload);
+		template <typename TComponent> static void DestroyPayload(void* payload);
+
+		std::vector<Block> blocks;
+		size_t currentBlock = 0;
+		int numCommands = 0;
+		//entities made by playback, index = placeholder number
+		std::vector<Entity> createdEntities;
+		int numCreatedEntities = 0;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -149,18 +839,31 @@ class Pool : public IPool
 class Registry {
 	private:
 		//management of entities
-		int numEntities = 0;
+		//one slot per entity id. a slot in use holds the generation handed out with the id,
+		//a free slot also links to the next free id so the free list lives inside the vector.
+		struct EntitySlot {
+			unsigned int generation = 0;
+			int nextFreeId = -1;
+			//set when the entity is waiting in entitiesWithChangedSignatures
+			bool isSignatureChanged = false;
+			//set when the entity is waiting in entitiesToBeAdded, its membership is worked out from scratch there
+			bool isAddPending = false;
+			//set when the entity is waiting in entitiesToBeKilled, so a kill is only queued once
+			bool isKillPending = false;
+		};
+		std::vector<EntitySlot> entitySlots;
+		//head of the free list, -1 when no previously used ids are available
+		int firstFreeId = -1;
 
-		//Sets of entites that are flagged to be added or removed. in next regisrty update.
-		std::set<Entity> entitiesToBeAdded;
-		std::set<Entity> entitiesToBeKilled;
-
-		//List of available IDs that were previously used.
-		std::deque<int> freeIds;
+		//entites that are flagged to be added or removed in the next regisrty update, flushed in bulk.
+		//plain vectors so a burst of spawns or kills does not allocate a node per entity.
+		//an id is only handed out once per update so adds can not repeat, kills are kept unique by isKillPending
+		std::vector<Entity> entitiesToBeAdded;
+		std::vector<Entity> entitiesToBeKilled;
 
 		//Vector of component pools, each pool contains all the data for each type of component
 		//vector index is the component type id.
-		//pool index is the entity id.
+		//each pool is a sparse set keyed by entity id.
 		std::vector<std::shared_ptr<IPool>> componentPools;
 
 		//Vector of component signatures.
@@ -168,12 +871,81 @@ class Registry {
 		//(vector index = entity id)
 		std::vector<Signature> entityComponenetSignatures;
 
+		//Signature each entity had the last time its system membership was updated.
+		//diffing it against the current signature tells which systems need to be checked.
+		//(vector index = entity id)
+		std::vector<Signature> entityMembershipSignatures;
+
+		//ids of entities that added or removed components since the last update
+		std::vector<int> entitiesWithChangedSignatures;
+		//queues the entity so Update re-evaluates its system membership once
+		void MarkSignatureChanged(int entityId);
+
 		//map of active systems, index = system typeid
 		std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
 
+		//one object per resource type, index = resource id. nullptr when the resource is not set
+		std::vector<std::unique_ptr<IResource>> resources;
+
+		//Selects whether components live in componentPools or in archetypeStorage
+		StorageMode storageMode;
+		ArchetypeStorage archetypeStorage;
+
+		//thread pool systems split their work over, not owned by the registry
+		ThreadPool* threadPool = nullptr;
+
+		//one command buffer per thread that asked for one, played back by Update
+		std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
+		std::mutex commandBuffersMutex;
+		//tells apart registries in the per thread buffer lookup, never reused
+		int registryId;
+		static std::atomic<int> nextRegistryId;
+		void PlaybackCommandBuffers();
+
+		//component events, removals come first so an observer that rebuilds
+		//derived data drops old entries before it sees new ones
+		enum ComponentEvent {
+			EVENT_REMOVED,
+			EVENT_ADDED,
+			EVENT_CHANGED,
+			NUM_COMPONENT_EVENTS
+		};
+		//observers of one component type and the entities waiting to be reported to them
+		struct ComponentObservers {
+			std::vector<std::function<void(Entity)>> observers[NUM_COMPONENT_EVENTS];
+			std::vector<Entity> pendingEntities[NUM_COMPONENT_EVENTS];
+		};
+		//index = component type id
+		std::vector<ComponentObservers> componentObservers;
+		void AddObserver(int componentId, ComponentEvent event, std::function<void(Entity)> observer);
+		//remembers the entity for the next NotifyObservers, only if someone observes the event
+		void QueueComponentEvent(int componentId, ComponentEvent event, Entity entity);
+		//calls the observers for every queued event, see OnAdd
+		void NotifyObservers();
+
+		//removes the killed entities from systems and storage and frees their ids
+		void KillPendingEntities();
+
+		//stamped on every component write, advanced by systems that track changes.
+		//starts above 0 so components written before any system ran count as changed
+		std::atomic<unsigned int> changeTick{ 1 };
+		template <typename TComponent> unsigned int& GetChangeTickOf(int entityId) const;
+
+		//returns the raw pool for the component type, or nullptr if no entity has used it yet
+		template <typename TComponent> Pool<TComponent>* GetPool() const;
+		//same as GetPool, but makes the pool the first time the component type is used
+		template <typename TComponent> Pool<TComponent>* GetOrCreatePool();
+
+		//views read the pools and chunks directly
+		template <typename ...TComponents> friend class EntityView;
+
+		//Prefab::Add keeps a pointer to the instantiation of this for its component type
+		friend class Prefab;
+		template <typename TComponent> static void AddPrefabComponentToPool(Registry& registry, const std::vector<Entity>& entities, const void* prototype);
+
 	public:
 		//prototype registry constructor 
-		Registry() { 
+		Registry(StorageMode storageMode = STORAGE_POOLS) : storageMode(storageMode), registryId(nextRegistryId++) { 
 			Logger::Log("Registry constructor called"); 
 		}
 		~Registry(){
@@ -183,11 +955,24 @@ class Registry {
 		void Update();
 		//method that will create a new entity and add it to entity to be added list
 		Entity CreateEntity();
+		//creates count entities at once, the entity bookkeeping is grown once for the whole batch
+		std::vector<Entity> CreateEntities(int count);
 		void KillEntity(Entity entity);
+		//true until the entity is removed by Update. stale copies of a recycled id return false
+		bool IsAlive(Entity entity) const {
+			const int entityId = entity.GetId();
+			return entityId >= 0 && entityId < static_cast<int>(entitySlots.size()) && entitySlots[entityId].generation == entity.GetGeneration();
+		}
 
 		///// Component related functions /////
 		//function that adds a component to an entity
 		template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+		//adds components[i] to entities[i] for the whole batch, storage is reserved once and the components are moved in.
+		//Example: registry->AddComponents<TransformComponent>(tiles, std::move(tileTransforms));
+		template <typename TComponent> void AddComponents(const std::vector<Entity>& entities, std::vector<TComponent> components);
+		//creates count entities that each get a copy of every component of the prefab, see Prefab.
+		//Example: std::vector<Entity> bullets = registry->Instantiate(bulletPrefab, 1000);
+		std::vector<Entity> Instantiate(const Prefab& prefab, int count = 1);
 		//Function that will remove a component from an entity
 		template <typename TComponent> void RemoveComponent(Entity entity);
 		//checks an entity to see if it has a specific component returns true if it does, false if it doesnt.
@@ -195,6 +980,58 @@ class Registry {
 		//returns component
 		template <typename TComponent> TComponent& GetComponent(Entity entity) const;
 
+		///// Resource related functions /////
+		//makes the registry's TResource from args, replacing the one it had. returns the new resource.
+		//set resources before the systems run, GetResource is safe from worker threads but setting one is not.
+		//Example: registry->SetResource<TimeResource>();
+		template <typename TResource, typename ...TArgs> TResource& SetResource(TArgs&& ...args);
+		template <typename TResource> void RemoveResource();
+		template <typename TResource> bool HasResource() const;
+		//returns the resource, it must have been set. systems that use it should RequireResource it
+		template <typename TResource> TResource& GetResource() const;
+
+		///// Observer related functions /////
+		//observer(entity) is called for every entity that got, lost or changed a component of type T.
+		//the calls are not made inline, they are made in one batch at the end of Update, once per entity
+		//and event no matter how often it happened. events are checked against the state at that point:
+		//OnAdd only fires if the entity still has the component (a replaced component fires it again),
+		//OnRemove only if it no longer has it, and the component is already gone by then.
+		//Example: registry->OnAdd<SpriteComponent>([this](Entity entity) { spritesToSort.push_back(entity); });
+		template <typename TComponent> void OnAdd(std::function<void(Entity)> observer);
+		template <typename TComponent> void OnRemove(std::function<void(Entity)> observer);
+		//OnChange observers only hear about changes reported with MarkChanged or Patch
+		template <typename TComponent> void OnChange(std::function<void(Entity)> observer);
+		//reports a component that was changed in place. from worker threads use the command buffer's MarkChanged
+		template <typename TComponent> void MarkChanged(Entity entity);
+		//calls func(component) and reports the change
+		//Example: registry->Patch<SpriteComponent>(entity, [](SpriteComponent& sprite) { sprite.zIndex = 3; });
+		template <typename TComponent, typename TFunc> void Patch(Entity entity, TFunc func);
+
+		///// Change tracking /////
+		//every component remembers the change tick of its last write. adding a component, views of non const
+		//components, MarkChanged and Patch stamp it. code that writes through GetComponent stamps it with MarkWritten.
+		//safe from worker threads as long as no other thread writes the same component of the same entity.
+		template <typename TComponent> void MarkWritten(Entity entity);
+		//change tick of the entity's component
+		template <typename TComponent> unsigned int GetChangeTick(Entity entity) const { return GetChangeTickOf<TComponent>(entity.GetId()); }
+		unsigned int GetChangeTick() const { return changeTick.load(std::memory_order_relaxed); }
+		//moves the tick forward and returns the tick before, see System::BeginChangeTracking
+		unsigned int AdvanceChangeTick() { return changeTick.fetch_add(1, std::memory_order_relaxed); }
+
+		//returns a view of every entity that has all of the components.
+		//Example: registry->View<TransformComponent, RigidBodyComponent>().Each([](Entity entity, TransformComponent& transform, RigidBodyComponent& rigidbody) {...});
+		template <typename ...TComponents> EntityView<TComponents...> View();
+
+		StorageMode GetStorageMode() const { return storageMode; }
+
+		//returns the command buffer of the calling thread. unlike the functions above it is
+		//safe to record into from systems running on worker threads, see CommandBuffer
+		CommandBuffer& GetCommandBuffer();
+
+		//System::ParallelForEach and EntityView::ParallelEach run on this pool, nullptr runs them on the calling thread
+		void SetThreadPool(ThreadPool* threadPool) { this->threadPool = threadPool; }
+		ThreadPool* GetThreadPool() const { return threadPool; }
+
 		////// System related functions /////
 		//adds system to registry unordered map "systems"
 		template <typename TSystem, typename ...TArgs> void AddSystem(TArgs&& ...args);
@@ -210,6 +1047,11 @@ class Registry {
 		void AddEntityToSystems(Entity entity);
 		// removes enetiy from used systems
 		void RemoveEntityFromSystems(Entity entity);
+		// adds/removes the entity from the systems affected by its signature changing
+		void UpdateEntityInSystems(Entity entity);
+		// same as above for a whole batch, each system goes through the batch in one pass
+		void AddEntitiesToSystems(const std::vector<Entity>& entities);
+		void RemoveEntitiesFromSystems(const std::vector<Entity>& entities);
 
 };
 //implemented template fuctions from registry prototype
@@ -220,45 +1062,163 @@ void Registry::AddComponent(Entity entity, TArgs&& ...args)
 	//get component id and entity id that we will be attac
 	const auto componentId = Component<TComponent>::GetId();
 	const auto entityId = entity.GetId();
-	//if component id is large than the componentPools vector size, resize to fit new component
-	if (componentId >= componentPools.size())
+
+	//tags have no data, there is only the signature bit to set. in archetype storage the entity
+	//still moves to the archetype with the tag, so views can tell tagged entities apart chunk by chunk
+	if constexpr (IsTagComponent<TComponent>::value)
 	{
-		componentPools.resize(componentId + 1, nullptr);
+		if (storageMode == STORAGE_CHUNKS)
+		{
+			archetypeStorage.AddComponent<TComponent>(entityId, componentId);
+		}
 	}
-	//if component pool at index does not exist create a new component pool at index
-	if (!componentPools[componentId])
+	//archetype storage constructs the component directly in the entity's chunk
+	else if (storageMode == STORAGE_CHUNKS)
 	{
-		std::shared_ptr<Pool<TComponent>> newComponentPool = std::make_shared<Pool<TComponent>>();
-		componentPools[componentId] = newComponentPool;
+		archetypeStorage.AddComponent<TComponent>(entityId, componentId, std::forward<TArgs>(args)...);
+		archetypeStorage.GetChangeTick(entityId, componentId) = GetChangeTick();
 	}
+	else
+	{
+		//get component pool location that we will be attaching to an entityid to and the new component too
+		Pool<TComponent>* componentPool = GetOrCreatePool<TComponent>();
 
-	//get component pool location that we will be attaching to an entityid to and the new component too
-	std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-
-	//if component pool is to small to accomedate the entity increase size of pool
-	if (entityId >= componentPool->GetSize()) {
-		componentPool->Resize(numEntities);
+		//construct the new component straight in the packed pool, keyed by entityid
+		componentPool->Emplace(entityId, std::forward<TArgs>(args)...);
+		componentPool->GetChangeTick(entityId) = GetChangeTick();
 	}
 
-	//create new component using default constructor
-	TComponent newComponent(std::forward<TArgs>(args)...);
-
-	//place the new component created at the entity's indexed position
-	//Place new componet into pool with entityid
-	componentPool->Set(entityId, newComponent);
-
 	//turn the component signature for the entity as "on" for the given component.
 	entityComponenetSignatures[entityId].set(componentId);
+	MarkSignatureChanged(entityId);
+	QueueComponentEvent(componentId, EVENT_ADDED, entity);
+}
+
+template <typename TComponent>
+void Registry::AddComponents(const std::vector<Entity>& entities, std::vector<TComponent> components)
+{
+	if (entities.size() != components.size())
+	{
+		Logger::Err("AddComponents needs one component per entity, got " + std::to_string(components.size()) + " for " + std::to_string(entities.size()) + " entities");
+		return;
+	}
+	const auto componentId = Component<TComponent>::GetId();
+
+	if constexpr (IsTagComponent<TComponent>::value)
+	{
+		if (storageMode == STORAGE_CHUNKS)
+		{
+			for (const Entity& entity : entities)
+			{
+				archetypeStorage.AddComponent<TComponent>(entity.GetId(), componentId);
+			}
+		}
+	}
+	else if (storageMode == STORAGE_CHUNKS)
+	{
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			archetypeStorage.AddComponent<TComponent>(entities[i].GetId(), componentId, std::move(components[i]));
+			archetypeStorage.GetChangeTick(entities[i].GetId(), componentId) = GetChangeTick();
+		}
+	}
+	else
+	{
+		//grow the pool once for the whole batch, then move the components into the packed data
+		Pool<TComponent>* componentPool = GetOrCreatePool<TComponent>();
+		int maxEntityId = -1;
+		for (const Entity& entity : entities)
+		{
+			maxEntityId = std::max(maxEntityId, entity.GetId());
+		}
+		componentPool->Reserve(componentPool->GetSize() + static_cast<int>(entities.size()), maxEntityId);
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			componentPool->Set(entities[i].GetId(), std::move(components[i]));
+			componentPool->GetChangeTick(entities[i].GetId()) = GetChangeTick();
+		}
+	}
+
+	//new entities have their system membership set when Update adds them, MarkSignatureChanged
+	//only queues the ones that were already live
+	for (const Entity& entity : entities)
+	{
+		entityComponenetSignatures[entity.GetId()].set(componentId);
+		MarkSignatureChanged(entity.GetId());
+		QueueComponentEvent(componentId, EVENT_ADDED, entity);
+	}
 
-	Logger::Log("Component ID [" + std::to_string(componentId) + "] was added to entity ID: " + std::to_string(entityId));
+	Logger::Log("Component ID [" + std::to_string(componentId) + "] was added to " + std::to_string(entities.size()) + " entities");
 }
 
 template <typename TComponent>
 void Registry::RemoveComponent(Entity entity) {
 	const auto componentId = Component<TComponent>::GetId();
 	const auto entityId = entity.GetId();
+	//drop the component from the packed pool so systems no longer iterate it
+	if (storageMode == STORAGE_CHUNKS)
+	{
+		if (entityComponenetSignatures[entityId].test(componentId))
+		{
+			archetypeStorage.RemoveComponent(entityId, componentId);
+		}
+	}
+	else if (componentId < static_cast<int>(componentPools.size()) && componentPools[componentId])
+	{
+		componentPools[componentId]->RemoveEntityFromPool(entityId);
+	}
 	entityComponenetSignatures[entityId].set(componentId, false);
-	Logger::Log("Component ID [" + std::to_string(componentId) + "] was removed from entity ID: " + std::to_string(entityId));
+	MarkSignatureChanged(entityId);
+	QueueComponentEvent(componentId, EVENT_REMOVED, entity);
+}
+
+template <typename TComponent>
+void Registry::OnAdd(std::function<void(Entity)> observer) {
+	AddObserver(Component<TComponent>::GetId(), EVENT_ADDED, std::move(observer));
+}
+
+template <typename TComponent>
+void Registry::OnRemove(std::function<void(Entity)> observer) {
+	AddObserver(Component<TComponent>::GetId(), EVENT_REMOVED, std::move(observer));
+}
+
+template <typename TComponent>
+void Registry::OnChange(std::function<void(Entity)> observer) {
+	AddObserver(Component<TComponent>::GetId(), EVENT_CHANGED, std::move(observer));
+}
+
+template <typename TComponent>
+void Registry::MarkChanged(Entity entity) {
+	MarkWritten<TComponent>(entity);
+	QueueComponentEvent(Component<TComponent>::GetId(), EVENT_CHANGED, entity);
+}
+
+template <typename TComponent>
+void Registry::MarkWritten(Entity entity) {
+	//tags have no change tick, there is nothing in them to write
+	if constexpr (!IsTagComponent<TComponent>::value)
+	{
+		if (HasComponent<TComponent>(entity))
+		{
+			GetChangeTickOf<TComponent>(entity.GetId()) = GetChangeTick();
+		}
+	}
+}
+
+template <typename TComponent>
+unsigned int& Registry::GetChangeTickOf(int entityId) const {
+	static_assert(!IsTagComponent<TComponent>::value, "tags have no change tick");
+	if (storageMode == STORAGE_CHUNKS)
+	{
+		return archetypeStorage.GetChangeTick(entityId, Component<TComponent>::GetId());
+	}
+	return GetPool<TComponent>()->GetChangeTick(entityId);
+}
+
+template <typename TComponent, typename TFunc>
+void Registry::Patch(Entity entity, TFunc func) {
+	func(GetComponent<TComponent>(entity));
+	MarkChanged<TComponent>(entity);
 }
 
 template <typename TComponent>
@@ -275,15 +1235,61 @@ TComponent& Registry::GetComponent(Entity entity) const
 {
 	const auto componentId = Component<TComponent>::GetId();
 	const auto entityId = entity.GetId();
-	auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-	return componentPool->Get(entityId);
+	//tags are not stored, every entity shares the one empty instance
+	if constexpr (IsTagComponent<TComponent>::value)
+	{
+		static TComponent tag;
+		return tag;
+	}
+	if (storageMode == STORAGE_CHUNKS)
+	{
+		return *static_cast<TComponent*>(archetypeStorage.GetComponent(entityId, componentId));
+	}
+	//raw pointer cast, avoids copying the shared_ptr on every lookup
+	return GetPool<TComponent>()->Get(entityId);
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetPool() const
+{
+	const auto componentId = Component<TComponent>::GetId();
+	if (componentId >= static_cast<int>(componentPools.size()))
+	{
+		return nullptr;
+	}
+	return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetOrCreatePool()
+{
+	const auto componentId = Component<TComponent>::GetId();
+	//if component id is large than the componentPools vector size, resize to fit new component
+	if (componentId >= static_cast<int>(componentPools.size()))
+	{
+		componentPools.resize(componentId + 1, nullptr);
+	}
+	//if component pool at index does not exist create a new component pool at index
+	if (!componentPools[componentId])
+	{
+		componentPools[componentId] = std::make_shared<Pool<TComponent>>();
+	}
+	return static_cast<Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename ...TComponents>
+EntityView<TComponents...> Registry::View()
+{
+	return EntityView<TComponents...>(this);
 }
 
 /////// F U N C T I O N S   F O R   S Y S T E M S ///////
 template <typename TSystem, typename ...TArgs> 
 void Registry::AddSystem(TArgs&& ...args) {
 	std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
+	newSystem->registry = this;
 	systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+	newSystem->OnAddedToRegistry();
 }
 
 template <typename TSystem>
@@ -294,7 +1300,7 @@ void Registry::RemoveSystem() {
 
 template <typename TSystem>
 bool Registry::HasSystem() const {
-	return (system.find(std::type_index(typeid(TSystem))) != systems.end());
+	return (systems.find(std::type_index(typeid(TSystem))) != systems.end());
 }
 
 template <typename TSystem> 
@@ -303,6 +1309,657 @@ TSystem& Registry::GetSystem() const{
 	return *(std::static_pointer_cast<TSystem>(system->second));
 }
 
+/////// F U N C T I O N S   F O R   R E S O U R C E S ///////
+template <typename TResource, typename ...TArgs>
+TResource& Registry::SetResource(TArgs&& ...args) {
+	const auto resourceId = Resource<TResource>::GetId();
+	if (resourceId >= static_cast<int>(resources.size())) {
+		resources.resize(resourceId + 1);
+	}
+	auto resource = std::make_unique<Resource<TResource>>(std::forward<TArgs>(args)...);
+	TResource& value = resource->value;
+	resources[resourceId] = std::move(resource);
+	return value;
+}
+
+template <typename TResource>
+void Registry::RemoveResource() {
+	if (HasResource<TResource>()) {
+		resources[Resource<TResource>::GetId()].reset();
+	}
+}
+
+template <typename TResource>
+bool Registry::HasResource() const {
+	const auto resourceId = Resource<TResource>::GetId();
+	return resourceId < static_cast<int>(resources.size()) && resources[resourceId] != nullptr;
+}
+
+template <typename TResource>
+TResource& Registry::GetResource() const {
+	return static_cast<Resource<TResource>*>(resources[Resource<TResource>::GetId()].get())->value;
+}
+
+/////// P R E F A B ///////
+template <typename TComponent, typename ...TArgs>
+Prefab& Prefab::Add(TArgs&& ...args) {
+	static_assert(std::is_copy_constructible<TComponent>::value, "prefab components are copied into every instance");
+	const auto componentId = Component<TComponent>::GetId();
+	auto component = std::make_shared<TComponent>(std::forward<TArgs>(args)...);
+	PrefabComponent prefabComponent = { { componentId, MakeComponentInfo<TComponent>(), component.get() }, component, &Registry::AddPrefabComponentToPool<TComponent> };
+
+	if (signature.test(componentId)) {
+		for (auto& existing : components) {
+			if (existing.prototype.componentId == componentId) {
+				existing = prefabComponent;
+			}
+		}
+		return *this;
+	}
+	signature.set(componentId);
+	components.push_back(prefabComponent);
+	return *this;
+}
+
+template <typename TComponent>
+const TComponent& Prefab::Get() const {
+	const auto componentId = Component<TComponent>::GetId();
+	auto component = std::find_if(components.begin(), components.end(), [componentId](const PrefabComponent& component) {
+		return component.prototype.componentId == componentId;
+	});
+	return *static_cast<const TComponent*>(component->prototype.component);
+}
+
+template <typename TComponent>
+void Registry::AddPrefabComponentToPool(Registry& registry, const std::vector<Entity>& entities, const void* prototype) {
+	if constexpr (IsTagComponent<TComponent>::value) {
+		return;
+	}
+	const TComponent& component = *static_cast<const TComponent*>(prototype);
+	Pool<TComponent>* componentPool = registry.GetOrCreatePool<TComponent>();
+	int maxEntityId = -1;
+	for (const Entity& entity : entities) {
+		maxEntityId = std::max(maxEntityId, entity.GetId());
+	}
+	//the pool grows once, then every instance is copied to the end of the packed data
+	componentPool->Reserve(componentPool->GetSize() + static_cast<int>(entities.size()), maxEntityId);
+	const unsigned int changeTick = registry.GetChangeTick();
+	for (const Entity& entity : entities) {
+		componentPool->Emplace(entity.GetId(), component);
+		componentPool->GetChangeTick(entity.GetId()) = changeTick;
+	}
+}
+
+/////// C O M M A N D   B U F F E R ///////
+//defined after the registry since playback calls into it
+template <typename TComponent, typename ...TArgs>
+void CommandBuffer::AddComponent(Entity entity, TArgs&& ...args) {
+	Command* command = AllocateCommand(COMMAND_ADD, entity, sizeof(TComponent), alignof(TComponent));
+	new (command->payload) TComponent(std::forward<TArgs>(args)...);
+	command->apply = &ApplyAdd<TComponent>;
+	command->destroy = &DestroyPayload<TComponent>;
+}
+
+template <typename TComponent>
+void CommandBuffer::RemoveComponent(Entity entity) {
+	Command* command = AllocateCommand(COMMAND_REMOVE, entity, 0, 1);
+	command->apply = &ApplyRemove<TComponent>;
+}
+
+template <typename TComponent>
+void CommandBuffer::MarkChanged(Entity entity) {
+	Command* command = AllocateCommand(COMMAND_CHANGE, entity, 0, 1);
+	command->apply = &ApplyChange<TComponent>;
+}
+
+template <typename TComponent>
+void CommandBuffer::ApplyAdd(Registry& registry, Entity entity, void* payload) {
+	registry.AddComponent<TComponent>(entity, std::move(*static_cast<TComponent*>(payload)));
+}
+
+template <typename TComponent>
+void CommandBuffer::ApplyRemove(Registry& registry, Entity entity, void*) {
+	registry.RemoveComponent<TComponent>(entity);
+}
+
+template <typename TComponent>
+void CommandBuffer::ApplyChange(Registry& registry, Entity entity, void*) {
+	registry.MarkChanged<TComponent>(entity);
+}
+
+template <typename TComponent>
+void CommandBuffer::DestroyPayload(void* payload) {
+	static_cast<TComponent*>(payload)->~TComponent();
+}
+
+/////// P A R A L L E L   I T E R A T I O N ///////
+//defined after the registry since it needs the registry's thread pool
+template <typename TFunc>
+void System::ParallelForEachChunk(TFunc func, ParallelMode mode, int grainSize) const {
+	const int numEntities = static_cast<int>(entities.size());
+	ThreadPool* threadPool = GetThreadPool();
+	const int grain = GetParallelGrainSize(mode, grainSize, numEntities, threadPool);
+	const int numChunks = (numEntities + grain - 1) / grain;
+
+	//one chunk is not worth a task
+	if (threadPool == nullptr || numChunks <= 1) {
+		for (int chunkIndex = 0; chunkIndex < numChunks; chunkIndex++) {
+			const int first = chunkIndex * grain;
+			func(chunkIndex, first, std::min(first + grain, numEntities));
+		}
+		return;
+	}
+
+	//func is shared by reference, Wait does not return until every chunk is done with it
+	TaskGroup group;
+	for (int chunkIndex = 0; chunkIndex < numChunks; chunkIndex++) {
+		const int first = chunkIndex * grain;
+		const int last = std::min(first + grain, numEntities);
+		threadPool->Submit(group, [&func, chunkIndex, first, last]() { func(chunkIndex, first, last); });
+	}
+	threadPool->Wait(group);
+}
+
+template <typename TFunc>
+void System::ParallelForEach(TFunc func, ParallelMode mode, int grainSize) const {
+	const Entity* systemEntities = entities.data();
+	ParallelForEachChunk([&func, systemEntities](int, int first, int last) {
+		for (int i = first; i < last; i++) {
+			func(systemEntities[i]);
+		}
+	}, mode, grainSize);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+/// V I E W
+//////////////////////////////////////////////////////////////////////////
+/// A view visits every entity that has all of the given components and
+/// hands out references straight from storage, nothing is copied or
+/// allocated. with pools the smallest pool is walked and the others are
+/// probed, with chunks the columns of every matching archetype are walked.
+/// components of the viewed types must not be added or removed while
+/// iterating since that can move them in storage.
+//////////////////////////////////////////////////////////////////////////
+
+template <typename ...TComponents>
+class EntityView {
+	static_assert((!IsTagComponent<TComponents>::value && ...), "tags have no data to hand out, filter on them with With<Tag>()");
+
+	public:
+		EntityView(Registry* registry);
+
+		//calls func(entity, components&...) for every entity in the view.
+		//func may return bool, then only the entities it returns true for count as written
+		template <typename TFunc> void Each(TFunc func);
+		//same as Each but split over the registry's thread pool. with chunks every archetype chunk is a task,
+		//with pools the smallest pool's entities are cut into chunks like System::ParallelForEach does,
+		//mode and grainSize pick the chunk size the same way. func may only touch the components it is given.
+		//Example: registry->View<TransformComponent, const RigidBodyComponent>().ParallelEach([](Entity, auto& t, auto& r) {...});
+		template <typename TFunc> void ParallelEach(TFunc func, ParallelMode mode = PARALLEL_FAST, int grainSize = 0);
+
+		//only visits entities where at least one of TChanged was written after sinceTick.
+		//TChanged must be components of the view.
+		//Example: registry->View<const TransformComponent>().Changed<TransformComponent>(sinceTick).Each(...)
+		//returns a copy so a range-for over a temporary view does not loop over a destroyed one
+		template <typename ...TChanged> EntityView Changed(unsigned int sinceTick) const;
+		//only visits entities that also have all of TWith, or none of TWithout. the components are not handed out,
+		//so these work with tags. like Changed they return a filtered copy.
+		//Example: registry->View<TransformComponent>().With<EnemyTag>().Without<StaticTag>().Each(...)
+		template <typename ...TWith> EntityView With() const;
+		template <typename ...TWithout> EntityView Without() const;
+
+		//forward iterator that yields std::tuple<Entity, TComponents&...>
+		//Example: for (auto [entity, transform, rigidbody] : view) {...}
+		class Iterator {
+			public:
+				Iterator(EntityView* view, bool isEnd);
+				std::tuple<Entity, TComponents&...> operator *() const;
+				Iterator& operator ++();
+				bool operator ==(const Iterator& other) const;
+				bool operator !=(const Iterator& other) const { return !(*this == other); }
+			private:
+				//moves forward from the current position to the next entity in the view
+				void FindNext();
+
+				EntityView* view;
+				//pools: position in the smallest pool. chunks: archetype, chunk and row
+				size_t index = 0;
+				size_t archetypeIndex = 0;
+				int chunkIndex = 0;
+				int row = 0;
+				int entityId = -1;
+				std::tuple<TComponents*...> components;
+		};
+		Iterator begin()	{ return Iterator(this, false); }
+		Iterator end()		{ return Iterator(this, true); }
+
+	private:
+		static constexpr size_t NUM_COMPONENTS = sizeof...(TComponents);
+
+		//fills components and their change ticks with the entity's, returns false if it is missing one
+		bool Probe(int entityId, std::tuple<TComponents*...>& components, unsigned int** changeTicks) const;
+		Entity MakeEntity(int entityId) const;
+		template <size_t ...TIndices>
+		void LoadPoolComponents(const int* indices, std::tuple<TComponents*...>& components, unsigned int** changeTicks, std::index_sequence<TIndices...>) const;
+		template <size_t ...TIndices>
+		void LoadChunkComponents(Archetype& archetype, int chunkIndex, int row, std::tuple<TComponents*...>& components, unsigned int** changeTicks, std::index_sequence<TIndices...>) const;
+		template <size_t ...TIndices>
+		std::tuple<TComponents*...> GetChunkColumns(Archetype& archetype, Chunk& chunk, std::index_sequence<TIndices...>) const;
+		//false when a Changed filter is set and none of the filtered components is newer than it
+		bool PassesChangedFilter(unsigned int* const* changeTicks) const;
+		//With and Without. chunks are matched by their archetype's signature, pools by the entity's
+		bool MatchesSignature(const Signature& entitySignature) const {
+			return entitySignature.Contains(signature) && !entitySignature.Intersects(withoutSignature);
+		}
+		bool PassesSignatureFilter(int entityId) const {
+			return !hasSignatureFilter || MatchesSignature(registry->entityComponenetSignatures[entityId]);
+		}
+		//stamps the components the view hands out as non const
+		void MarkWritten(unsigned int* const* changeTicks) const;
+		//the loops of Each and ParallelEach: every row of one chunk, or the smallest pool's entities from first to last
+		template <typename TFunc> void EachInChunk(Archetype& archetype, Chunk& chunk, TFunc& func) const;
+		template <typename TFunc> void EachInRange(size_t first, size_t last, TFunc& func) const;
+		//calls func for one entity and stamps what it wrote
+		template <typename TFunc> void Visit(TFunc& func, int entityId, unsigned int* const* changeTicks, TComponents&... components) const;
+
+		Registry* registry;
+		std::tuple<Pool<typename std::remove_const<TComponents>::type>*...> pools;
+		//packed entity ids of the smallest pool, nullptr when one of the pools does not exist
+		const std::vector<int>* leadEntityIds = nullptr;
+		//the view's components plus With, and the components of Without
+		Signature signature;
+		Signature withoutSignature;
+		bool hasSignatureFilter = false;
+		int componentIds[NUM_COMPONENTS];
+		//views of non const components count as writing them
+		bool isWritten[NUM_COMPONENTS] = { !std::is_const<TComponents>::value... };
+		bool isAnyWritten = (!std::is_const<TComponents>::value || ...);
+		unsigned int writeTick;
+		//Changed filter, isChangeFiltered is indexed like componentIds
+		bool isChangeFiltered[NUM_COMPONENTS] = {};
+		bool hasChangedFilter = false;
+		unsigned int changedSinceTick = 0;
+};
+
+template <typename ...TComponents>
+EntityView<TComponents...>::EntityView(Registry* registry)
+	: registry(registry), pools(registry->GetPool<typename std::remove_const<TComponents>::type>()...),
+	componentIds{ Component<TComponents>::GetId()... }, writeTick(registry->GetChangeTick())
+{
+	for (int componentId : componentIds)
+	{
+		signature.set(componentId);
+	}
+	if (registry->storageMode == STORAGE_CHUNKS)
+	{
+		return;
+	}
+	//iterate the pool with the fewest components, every other pool is only probed
+	const bool allPoolsExist = ((std::get<Pool<typename std::remove_const<TComponents>::type>*>(pools) != nullptr) && ...);
+	if (!allPoolsExist)
+	{
+		return;
+	}
+	int smallestSize = -1;
+	auto pickSmallest = [&](auto* pool) {
+		if (smallestSize == -1 || pool->GetSize() < smallestSize)
+		{
+			smallestSize = pool->GetSize();
+			leadEntityIds = &pool->GetEntityIds();
+		}
+	};
+	(pickSmallest(std::get<Pool<typename std::remove_const<TComponents>::type>*>(pools)), ...);
+}
+
+template <typename ...TComponents>
+template <typename ...TChanged>
+EntityView<TComponents...> EntityView<TComponents...>::Changed(unsigned int sinceTick) const
+{
+	EntityView view = *this;
+	const int changedIds[] = { Component<TChanged>::GetId()... };
+	for (int changedId : changedIds)
+	{
+		for (size_t i = 0; i < NUM_COMPONENTS; i++)
+		{
+			view.isChangeFiltered[i] = view.isChangeFiltered[i] || componentIds[i] == changedId;
+		}
+	}
+	view.hasChangedFilter = true;
+	view.changedSinceTick = sinceTick;
+	return view;
+}
+
+template <typename ...TComponents>
+template <typename ...TWith>
+EntityView<TComponents...> EntityView<TComponents...>::With() const
+{
+	EntityView view = *this;
+	(view.signature.set(Component<TWith>::GetId()), ...);
+	view.hasSignatureFilter = true;
+	return view;
+}
+
+template <typename ...TComponents>
+template <typename ...TWithout>
+EntityView<TComponents...> EntityView<TComponents...>::Without() const
+{
+	EntityView view = *this;
+	(view.withoutSignature.set(Component<TWithout>::GetId()), ...);
+	view.hasSignatureFilter = true;
+	return view;
+}
+
+template <typename ...TComponents>
+bool EntityView<TComponents...>::PassesChangedFilter(unsigned int* const* changeTicks) const
+{
+	if (!hasChangedFilter)
+	{
+		return true;
+	}
+	for (size_t i = 0; i < NUM_COMPONENTS; i++)
+	{
+		if (isChangeFiltered[i] && *changeTicks[i] > changedSinceTick)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename ...TComponents>
+void EntityView<TComponents...>::MarkWritten(unsigned int* const* changeTicks) const
+{
+	if (!isAnyWritten)
+	{
+		return;
+	}
+	for (size_t i = 0; i < NUM_COMPONENTS; i++)
+	{
+		if (isWritten[i])
+		{
+			*changeTicks[i] = writeTick;
+		}
+	}
+}
+
+template <typename ...TComponents>
+bool EntityView<TComponents...>::Probe(int entityId, std::tuple<TComponents*...>& components, unsigned int** changeTicks) const
+{
+	const int indices[] = { std::get<Pool<typename std::remove_const<TComponents>::type>*>(pools)->IndexOf(entityId)...  };
+	for (int index : indices)
+	{
+		if (index == -1)
+		{
+			return false;
+		}
+	}
+	LoadPoolComponents(indices, components, changeTicks, std::index_sequence_for<TComponents...>());
+	return true;
+}
+
+template <typename ...TComponents>
+template <size_t ...TIndices>
+void EntityView<TComponents...>::LoadPoolComponents(const int* indices, std::tuple<TComponents*...>& components, unsigned int** changeTicks, std::index_sequence<TIndices...>) const
+{
+	components = std::tuple<TComponents*...>(&std::get<TIndices>(pools)->GetAt(indices[TIndices])...);
+	((changeTicks[TIndices] = &std::get<TIndices>(pools)->GetChangeTickAt(indices[TIndices])), ...);
+}
+
+template <typename ...TComponents>
+template <size_t ...TIndices>
+void EntityView<TComponents...>::LoadChunkComponents(Archetype& archetype, int chunkIndex, int row, std::tuple<TComponents*...>& components, unsigned int** changeTicks, std::index_sequence<TIndices...>) const
+{
+	components = std::make_tuple(static_cast<TComponents*>(archetype.GetComponent(chunkIndex, row, componentIds[TIndices]))...);
+	((changeTicks[TIndices] = &archetype.GetChangeTick(chunkIndex, row, componentIds[TIndices])), ...);
+}
+
+template <typename ...TComponents>
+template <size_t ...TIndices>
+std::tuple<TComponents*...> EntityView<TComponents...>::GetChunkColumns(Archetype& archetype, Chunk& chunk, std::index_sequence<TIndices...>) const
+{
+	return std::tuple<TComponents*...>(archetype.template GetColumn<TComponents>(chunk, componentIds[TIndices])...);
+}
+
+template <typename ...TComponents>
+Entity EntityView<TComponents...>::MakeEntity(int entityId) const
+{
+	Entity entity(entityId, registry->entitySlots[entityId].generation);
+	entity.registry = registry;
+	return entity;
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+void EntityView<TComponents...>::Visit(TFunc& func, int entityId, unsigned int* const* changeTicks, TComponents&... components) const
+{
+	if constexpr (std::is_same<typename std::invoke_result<TFunc&, Entity, TComponents&...>::type, bool>::value)
+	{
+		//the system tells which entities it really changed, the others keep their change ticks
+		if (func(MakeEntity(entityId), components...))
+		{
+			MarkWritten(changeTicks);
+		}
+	}
+	else
+	{
+		MarkWritten(changeTicks);
+		func(MakeEntity(entityId), components...);
+	}
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+void EntityView<TComponents...>::EachInChunk(Archetype& archetype, Chunk& chunk, TFunc& func) const
+{
+	//walk the columns of the chunk side by side
+	unsigned int* changeTicks[NUM_COMPONENTS];
+	const int* entityIds = archetype.GetEntityIds(chunk);
+	for (size_t i = 0; i < NUM_COMPONENTS; i++)
+	{
+		changeTicks[i] = archetype.GetChangeTicks(chunk, componentIds[i]);
+	}
+	const std::tuple<TComponents*...> columns = GetChunkColumns(archetype, chunk, std::index_sequence_for<TComponents...>());
+	for (int row = 0; row < chunk.count; row++)
+	{
+		if (PassesChangedFilter(changeTicks))
+		{
+			Visit(func, entityIds[row], changeTicks, std::get<TComponents*>(columns)[row]...);
+		}
+		for (auto& changeTick : changeTicks)
+		{
+			changeTick++;
+		}
+	}
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+void EntityView<TComponents...>::EachInRange(size_t first, size_t last, TFunc& func) const
+{
+	unsigned int* changeTicks[NUM_COMPONENTS];
+	std::tuple<TComponents*...> components;
+	for (size_t i = first; i < last; i++)
+	{
+		const int entityId = (*leadEntityIds)[i];
+		if (PassesSignatureFilter(entityId) && Probe(entityId, components, changeTicks) && PassesChangedFilter(changeTicks))
+		{
+			Visit(func, entityId, changeTicks, *std::get<TComponents*>(components)...);
+		}
+	}
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+void EntityView<TComponents...>::Each(TFunc func)
+{
+	if (registry->storageMode == STORAGE_CHUNKS)
+	{
+		for (auto& archetype : registry->archetypeStorage.GetArchetypes())
+		{
+			if (!MatchesSignature(archetype->GetSignature()))
+			{
+				continue;
+			}
+			for (int chunkIndex = 0; chunkIndex < archetype->GetNumChunks(); chunkIndex++)
+			{
+				EachInChunk(*archetype, archetype->GetChunk(chunkIndex), func);
+			}
+		}
+		return;
+	}
+	if (leadEntityIds)
+	{
+		EachInRange(0, leadEntityIds->size(), func);
+	}
+}
+
+template <typename ...TComponents>
+template <typename TFunc>
+void EntityView<TComponents...>::ParallelEach(TFunc func, ParallelMode mode, int grainSize)
+{
+	ThreadPool* threadPool = registry->GetThreadPool();
+	if (threadPool == nullptr)
+	{
+		Each(func);
+		return;
+	}
+
+	//func is shared by reference, Wait does not return until every task is done with it
+	TaskGroup group;
+	if (registry->storageMode == STORAGE_CHUNKS)
+	{
+		//a chunk is already a few hundred rows of contiguous columns, the right size for one task.
+		//its bounds do not depend on the thread count either, so both modes split the same way
+		for (auto& archetype : registry->archetypeStorage.GetArchetypes())
+		{
+			if (!MatchesSignature(archetype->GetSignature()))
+			{
+				continue;
+			}
+			for (int chunkIndex = 0; chunkIndex < archetype->GetNumChunks(); chunkIndex++)
+			{
+				Archetype* chunkArchetype = archetype.get();
+				Chunk* chunk = &archetype->GetChunk(chunkIndex);
+				threadPool->Submit(group, [this, &func, chunkArchetype, chunk]() { EachInChunk(*chunkArchetype, *chunk, func); });
+			}
+		}
+		threadPool->Wait(group);
+		return;
+	}
+	if (!leadEntityIds)
+	{
+		return;
+	}
+
+	const size_t numEntities = leadEntityIds->size();
+	const size_t grain = static_cast<size_t>(GetParallelGrainSize(mode, grainSize, static_cast<int>(numEntities), threadPool));
+	//one range is not worth a task
+	if (numEntities <= grain)
+	{
+		EachInRange(0, numEntities, func);
+		return;
+	}
+	for (size_t first = 0; first < numEntities; first += grain)
+	{
+		const size_t last = std::min(first + grain, numEntities);
+		threadPool->Submit(group, [this, &func, first, last]() { EachInRange(first, last, func); });
+	}
+	threadPool->Wait(group);
+}
+
+template <typename ...TComponents>
+EntityView<TComponents...>::Iterator::Iterator(EntityView* view, bool isEnd) : view(view)
+{
+	if (isEnd)
+	{
+		//an end iterator sits one past the last position of the storage being walked
+		if (view->registry->storageMode == STORAGE_CHUNKS)
+		{
+			archetypeIndex = view->registry->archetypeStorage.GetArchetypes().size();
+		}
+		else if (view->leadEntityIds)
+		{
+			index = view->leadEntityIds->size();
+		}
+		return;
+	}
+	FindNext();
+}
+
+template <typename ...TComponents>
+void EntityView<TComponents...>::Iterator::FindNext()
+{
+	unsigned int* changeTicks[NUM_COMPONENTS];
+	if (view->registry->storageMode == STORAGE_CHUNKS)
+	{
+		const auto& archetypes = view->registry->archetypeStorage.GetArchetypes();
+		for (; archetypeIndex < archetypes.size(); archetypeIndex++, chunkIndex = 0, row = 0)
+		{
+			Archetype& archetype = *archetypes[archetypeIndex];
+			if (!view->MatchesSignature(archetype.GetSignature()))
+			{
+				continue;
+			}
+			for (; chunkIndex < archetype.GetNumChunks(); chunkIndex++, row = 0)
+			{
+				Chunk& chunk = archetype.GetChunk(chunkIndex);
+				for (; row < chunk.count; row++)
+				{
+					view->LoadChunkComponents(archetype, chunkIndex, row, components, changeTicks, std::index_sequence_for<TComponents...>());
+					if (view->PassesChangedFilter(changeTicks))
+					{
+						entityId = archetype.GetEntityIds(chunk)[row];
+						view->MarkWritten(changeTicks);
+						return;
+					}
+				}
+			}
+		}
+		return;
+	}
+	if (!view->leadEntityIds)
+	{
+		return;
+	}
+	const std::vector<int>& entityIds = *view->leadEntityIds;
+	for (; index < entityIds.size(); index++)
+	{
+		if (view->PassesSignatureFilter(entityIds[index]) && view->Probe(entityIds[index], components, changeTicks) && view->PassesChangedFilter(changeTicks))
+		{
+			entityId = entityIds[index];
+			view->MarkWritten(changeTicks);
+			return;
+		}
+	}
+}
+
+template <typename ...TComponents>
+typename EntityView<TComponents...>::Iterator& EntityView<TComponents...>::Iterator::operator ++()
+{
+	if (view->registry->storageMode == STORAGE_CHUNKS)
+	{
+		row++;
+	}
+	else
+	{
+		index++;
+	}
+	FindNext();
+	return *this;
+}
+
+template <typename ...TComponents>
+std::tuple<Entity, TComponents&...> EntityView<TComponents...>::Iterator::operator *() const
+{
+	return std::tuple<Entity, TComponents&...>(view->MakeEntity(entityId), *std::get<TComponents*>(components)...);
+}
+
+template <typename ...TComponents>
+bool EntityView<TComponents...>::Iterator::operator ==(const Iterator& other) const
+{
+	return index == other.index && archetypeIndex == other.archetypeIndex && chunkIndex == other.chunkIndex && row == other.row;
+}
 
 /////// F U N C T I O N S   F O R   E N T I T I E S ///////
 //These functions are located in entity however they are just calling the registry template fuctiosn above
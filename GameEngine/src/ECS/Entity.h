@@ -0,0 +1,49 @@
+#ifndef ENTITY_H
+#define ENTITY_H
+//the Entity class on its own, so components that hold an entity (ParentComponent) can include it
+//without ECS.h. ECS.h includes this file and defines the template members further down.
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+/// E N T I T Y
+/////////////////////////////////////////////////////////////////////////////
+/// entities are objects that only give an identifier to a game object
+/// the identifier is an index (id) plus a generation. the generation goes up
+/// every time the id is recycled, so an old copy of an entity no longer
+/// matches the new entity that reuses its id. see Registry::IsAlive.
+/////////////////////////////////////////////////////////////////////////////
+
+class Registry;//forward declaration
+
+class Entity {
+	public:
+		Entity(int id, unsigned int generation = 0) : id(id), generation(generation) {}; //using initializer list to initialized id
+		Entity(const Entity& entity) = default; //overloaded constructor using default build.
+		int GetId() const;//getter method. the id is the index used by pools and signatures
+		unsigned int GetGeneration() const;
+		void Kill();//kills entity, removes from systems, and reallocates id to be reused
+		bool IsAlive() const;//false once the entity was killed, even if its id has been reused
+
+		//operator overloading to define the meaning of creating an entities based on another
+		Entity& operator = (const Entity& other) = default;
+		//operator overloading to define the meaning of comparing two entities with ==
+		bool operator == (const Entity& other) const {return id == other.id && generation == other.generation;}
+		//operator overloaded to define the meaning of comparing two entities with !=
+		bool operator != (const Entity& other) const {return !(*this == other);}
+		bool operator >(const Entity& other) const { return other < *this; }
+		bool operator <(const Entity& other) const { return id < other.id || (id == other.id && generation < other.generation); }
+
+		// Hold a pointer to the entity's owner registry, null for an entity that was never created by one
+		Registry* registry = nullptr;
+
+		// methods to control registry through the entity.
+		//surves no purpose beside making syntax easier when adding components to entities.
+		template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
+		template <typename TComponent> void RemoveComponent();
+		template <typename TComponent> bool HasComponent() const;
+		template <typename TComponent> TComponent& GetComponent() const;
+	private:
+		int id;
+		unsigned int generation;
+};
+
+#endif
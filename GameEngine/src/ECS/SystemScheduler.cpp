@@ -0,0 +1,47 @@
+#include "SystemScheduler.h"
+
+void SystemScheduler::Schedule(System& system, std::function<void()> update) {
+	auto job = std::make_unique<Job>();
+	job->system = &system;
+	job->update = std::move(update);
+	jobs.push_back(std::move(job));
+}
+
+void SystemScheduler::Run(ThreadPool& threadPool) {
+	//every job depends on the earlier jobs it conflicts with
+	for (size_t i = 0; i < jobs.size(); i++) {
+		for (size_t j = 0; j < i; j++) {
+			if (jobs[i]->system->ConflictsWith(*jobs[j]->system)) {
+				jobs[j]->dependents.push_back(static_cast<int>(i));
+				jobs[i]->remainingDependencies++;
+			}
+		}
+	}
+
+	//start everything that does not wait on another job, the rest is started as dependencies finish.
+	//the roots are collected first, a root that finishes early would otherwise release a job we have yet to look at.
+	std::vector<int> roots;
+	for (size_t i = 0; i < jobs.size(); i++) {
+		if (jobs[i]->remainingDependencies == 0) {
+			roots.push_back(static_cast<int>(i));
+		}
+	}
+	TaskGroup group;
+	for (int jobIndex : roots) {
+		threadPool.Submit(group, [this, jobIndex, &threadPool, &group]() { RunJob(jobIndex, threadPool, group); });
+	}
+	threadPool.Wait(group);
+
+	jobs.clear();
+}
+
+void SystemScheduler::RunJob(int jobIndex, ThreadPool& threadPool, TaskGroup& group) {
+	Job& job = *jobs[jobIndex];
+	job.update();
+
+	for (int dependentIndex : job.dependents) {
+		if (--jobs[dependentIndex]->remainingDependencies == 0) {
+			threadPool.Submit(group, [this, dependentIndex, &threadPool, &group]() { RunJob(dependentIndex, threadPool, group); });
+		}
+	}
+}
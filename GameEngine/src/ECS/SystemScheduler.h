@@ -0,0 +1,47 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+#include "ECS.h"
+#include "../ThreadPool/ThreadPool.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// S Y S T E M   S C H E D U L E R
+/////////////////////////////////////////////////////////////////////////////
+// Runs the system updates of a frame on a thread pool. every frame the
+// scheduled systems are turned into a dependency graph: a system waits for
+// every system scheduled before it that conflicts with it (see
+// System::ConflictsWith), all other systems run at the same time. conflicting
+// systems therefore keep the order they were scheduled in.
+/////////////////////////////////////////////////////////////////////////////
+
+class SystemScheduler {
+	public:
+		//queues the system for this frame. update is the call that runs it,
+		//Example: scheduler.Schedule(movementSystem, [&]() { movementSystem.Update(); });
+		void Schedule(System& system, std::function<void()> update);
+
+		//builds the dependency graph, runs every scheduled system and returns once they all finished.
+		//the schedule is cleared afterwards.
+		void Run(ThreadPool& threadPool);
+
+	private:
+		struct Job {
+			System* system;
+			std::function<void()> update;
+			//jobs that can only start after this one
+			std::vector<int> dependents;
+			//jobs this one is still waiting on
+			std::atomic<int> remainingDependencies{ 0 };
+		};
+
+		//runs the job then releases every dependent whose last dependency it was
+		void RunJob(int jobIndex, ThreadPool& threadPool, TaskGroup& group);
+
+		std::vector<std::unique_ptr<Job>> jobs;
+};
+
+#endif
@@ -4,11 +4,17 @@
 #include "../Systems/AnimationSystem.h"
 #include "../Systems/CollisionSystem.h"
 #include "../Systems/RenderColliderSystem.h"
+#include "../Systems/HierarchySystem.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/AnimationComponent.h"
 #include "../Components/BoxColliderComponent.h"
+#include "../Components/EnemyTag.h"
+#include "../Components/StaticTag.h"
+#include "../Resources/TimeResource.h"
+#include "../Resources/WindowResource.h"
+#include "../Resources/RenderResource.h"
 #include "../Logger/Logger.h"
 #include "../ECS/ECS.h"
 #include <SDL.h>
@@ -17,17 +23,24 @@
 #include <iostream>
 #include <fstream>
 
-Game::Game() {
+Game::Game(StorageMode storageMode, BroadphaseType broadphaseType) {
 	isRunning = false;
 	isDebug = false;
+	//broadphase can be switched from the command line to compare them on the same scene
+	this->broadphaseType = broadphaseType;
 	windowWidth = 0;
 	windowHeight = 0;
 	window = NULL;//initializing window as null
 	renderer = NULL;//initializing renderer as null
 
 	//makes the regitry for ECS and assetStore for textures, audio, and fonts
-	registry = std::make_unique<Registry>();
+	//storage mode can be switched from the command line to compare pools against archetype chunks
+	registry = std::make_unique<Registry>(storageMode);
 	assetStore = std::make_unique<AssetStore>();
+	threadPool = std::make_unique<ThreadPool>();
+	registry->SetThreadPool(threadPool.get());
+	//frame time every system can read, see Game::timeControl
+	registry->SetResource<TimeResource>();
 
 	Logger::Log("game constructor called");
 }
@@ -89,6 +102,10 @@ void Game::Initialize(int window_width, int window_height) {
 		return;
 	}
 
+	//window and renderer are shared with the systems through the registry
+	registry->SetResource<WindowResource>(windowWidth, windowHeight);
+	registry->SetResource<RenderResource>(renderer, assetStore.get());
+
 	//if game window is initialized with non defualt values set a windowed fullscreen mode of program
 	if (window_width != 0 && window_height != 0)
 	{
@@ -112,10 +129,11 @@ void Game::timeControl() {
 	//difference in ticks from last frame. converted to second
 	//this creates a pixels per second relationship within update method.
 	//use this time for any moving game object by multiplying it with deltatime.
-	deltaTime = ((SDL_GetTicks() - millisecsPreviousFrame) / 1000.0);
+	const Uint32 ticks = SDL_GetTicks();
+	registry->GetResource<TimeResource>().deltaTime = ((ticks - millisecsPreviousFrame) / 1000.0);
 
 	//store frame time
-	millisecsPreviousFrame = SDL_GetTicks();
+	millisecsPreviousFrame = ticks;
 }
 //function that will start the game loop after initiaization of game
 void Game::Run() {
@@ -133,8 +151,9 @@ void Game::LoadScene(int sceneId) {
 	registry->AddSystem<MovementSystem>();
 	registry->AddSystem<RenderSystem>();
 	registry->AddSystem<AnimationSystem>();
-	registry->AddSystem<CollisionSystem>();
+	registry->AddSystem<CollisionSystem>(broadphaseType);
 	registry->AddSystem<RenderColliderSystem>();
+	registry->AddSystem<HierarchySystem>();
 
 	// Adding assets to the asset store
 	assetStore->AddTexture(renderer, "tank-image", "./assets/images/tank-panther-right.png");
@@ -152,6 +171,12 @@ void Game::LoadScene(int sceneId) {
 	std::fstream mapFile;
 	mapFile.open("./assets/tilemaps/jungle.map");
 
+	//read the whole map first, then make the tiles as one batch
+	std::vector<TransformComponent> tileTransforms;
+	std::vector<SpriteComponent> tileSprites;
+	tileTransforms.reserve(mapNumRows * mapNumCols);
+	tileSprites.reserve(mapNumRows * mapNumCols);
+
 	for (int y = 0; y < mapNumRows; y++) {
 		for (int x = 0; x < mapNumCols; x++) {
 			char ch;
@@ -161,13 +186,17 @@ void Game::LoadScene(int sceneId) {
 			int srcRectX = std::atoi(&ch) * tileSize;
 			mapFile.ignore();
 
-			Entity tile = registry->CreateEntity();
-			tile.AddComponent<TransformComponent>(glm::vec2(x * (tileScale * tileSize), y * (tileScale * tileSize)), glm::vec2(tileScale, tileScale), 0.0);
-			tile.AddComponent<SpriteComponent>("tilemap-image",tileSize, tileSize, 0, srcRectX, srcRectY);
+			tileTransforms.emplace_back(glm::vec2(x * (tileScale * tileSize), y * (tileScale * tileSize)), glm::vec2(tileScale, tileScale), 0.0);
+			tileSprites.emplace_back("tilemap-image", tileSize, tileSize, 0, srcRectX, srcRectY);
 		}
 	}
 	mapFile.close();
 
+	std::vector<Entity> tiles = registry->CreateEntities(mapNumRows * mapNumCols);
+	registry->AddComponents<TransformComponent>(tiles, std::move(tileTransforms));
+	registry->AddComponents<SpriteComponent>(tiles, std::move(tileSprites));
+	registry->AddComponents<StaticTag>(tiles, std::vector<StaticTag>(tiles.size()));
+
 	// Create an entity
 	Entity chopper = registry->CreateEntity();
 	chopper.AddComponent<TransformComponent>(glm::vec2(100.0, 100.0), glm::vec2(1.0, 1.0), 0.0);
@@ -187,13 +216,15 @@ void Game::LoadScene(int sceneId) {
 	tank.AddComponent<TransformComponent>(glm::vec2(300.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
 	tank.AddComponent<RigidBodyComponent>(glm::vec2(-20.0, 0.0));
 	tank.AddComponent<SpriteComponent>("tank-image", 32, 32, 1);
-	tank.AddComponent<BoxColliderComponent>(32,32);
+	tank.AddComponent<BoxColliderComponent>(32,32,glm::vec2(0),COLLISION_LAYER_ENEMY);
+	tank.AddComponent<EnemyTag>();
 
 	Entity truck = registry->CreateEntity();
 	truck.AddComponent<TransformComponent>(glm::vec2(10.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
 	truck.AddComponent<RigidBodyComponent>(glm::vec2(20.0, 0.0));
 	truck.AddComponent<SpriteComponent>("truck-image", 32, 32, 1);
-	truck.AddComponent<BoxColliderComponent>(32,32);
+	truck.AddComponent<BoxColliderComponent>(32,32,glm::vec2(0),COLLISION_LAYER_ENEMY);
+	truck.AddComponent<EnemyTag>();
 }
 
 //method used to setup game object location, size, etc...
@@ -202,12 +233,25 @@ void Game::Setup() {
 }
 
 void Game::Update() {
+	//the frame's clock is read before any system runs, so animations see this frame's time and not the last one's
+	registry->GetResource<TimeResource>().ticks = SDL_GetTicks();
 	//Update the registry to process the entites that are waiting to be created or destroyed
 	registry->Update();
 	//System updates positions of entites based on rigidBody values.
-	registry->GetSystem<CollisionSystem>().Update();
-	registry->GetSystem<MovementSystem>().Update(deltaTime);
-	registry->GetSystem<AnimationSystem>().Update(deltaTime);
+	//the scheduler runs systems that do not write the same components at the same time,
+	//systems that do conflict run in the order they are scheduled here.
+	auto& collisionSystem = registry->GetSystem<CollisionSystem>();
+	auto& movementSystem = registry->GetSystem<MovementSystem>();
+	auto& animationSystem = registry->GetSystem<AnimationSystem>();
+	auto& hierarchySystem = registry->GetSystem<HierarchySystem>();
+	scheduler.Schedule(collisionSystem, [&collisionSystem]() { collisionSystem.Update(); });
+	scheduler.Schedule(movementSystem, [&movementSystem]() { movementSystem.Update(); });
+	scheduler.Schedule(animationSystem, [&animationSystem]() { animationSystem.Update(); });
+	//attached entities follow their parents after the parents moved
+	scheduler.Schedule(hierarchySystem, [&hierarchySystem]() { hierarchySystem.Update(); });
+	scheduler.Run(*threadPool);
+	//the collisions are logged here and not from the collision system's worker thread
+	collisionSystem.LogCollisions();
 }
 
 void Game::Render() {
@@ -215,9 +259,9 @@ void Game::Render() {
 	SDL_RenderClear(renderer);//sets background to the above color of renderer.
 
 	//System renders images to the location based on transform component
-	registry->GetSystem<RenderSystem>().Update(renderer, assetStore);
+	registry->GetSystem<RenderSystem>().Update();
 	//Debug rendered items, such as collision boxes.
-	if(isDebug){ registry->GetSystem<RenderColliderSystem>().Update(renderer); }
+	if(isDebug){ registry->GetSystem<RenderColliderSystem>().Update(); }
 
 
 	SDL_RenderPresent(renderer);//presents what is on renderer to window
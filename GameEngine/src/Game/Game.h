@@ -2,7 +2,10 @@
 #define GAME_H
 
 #include "../ECS/ECS.h"
+#include "../ECS/SystemScheduler.h"
+#include "../ThreadPool/ThreadPool.h"
 #include "../AssetStore/AssetStore.h"
+#include "../Collision/Broadphase.h"
 #include <SDL.h>
 #include <memory>
 
@@ -13,7 +16,7 @@ const int MILLISECS_PER_FRAME = 1000 / FPS;
 class Game {
 	//public methods are the public api. application programming interface.
 	public:
-		Game();
+		Game(StorageMode storageMode = STORAGE_POOLS, BroadphaseType broadphaseType = BROADPHASE_GRID);
 		~Game();
 		void Initialize(int window_width = 0, int window_height = 0);
 		void Run();
@@ -31,7 +34,7 @@ class Game {
 	private:
 		bool isRunning;
 		bool isDebug;
-		double deltaTime = 0;
+		BroadphaseType broadphaseType;
 		int millisecsPreviousFrame = 0;
 		SDL_Window* window;
 		SDL_Renderer* renderer;
@@ -39,6 +42,10 @@ class Game {
 		std::unique_ptr<AssetStore> assetStore;
 		std::unique_ptr<Registry> registry;
 		std::unique_ptr<EventBus> eventBus;
+
+		//runs the update systems on every core, see Game::Update
+		std::unique_ptr<ThreadPool> threadPool;
+		SystemScheduler scheduler;
 };
 
 #endif
\ No newline at end of file
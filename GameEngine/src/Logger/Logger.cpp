@@ -5,6 +5,7 @@
 #include <ctime>
 
 std::vector<LogEntry> Logger::messages;
+std::mutex Logger::mutex;
 
 //method below creates a string that formats the time and date into a neat string that will be used by logger class
 std::string Logger::CurrentDateTimeToString() {
@@ -23,6 +24,7 @@ void Logger::Log(const std::string& msg) {
 	logEntry.type = LOG_INFO;
 	logEntry.message = "LOG: [" + CurrentDateTimeToString() + "]: " + msg;
 
+	std::lock_guard<std::mutex> lock(mutex);
 	std::cout << "\x1B[32m" << logEntry.message << "\033[0m" << std::endl;
 
 	messages.push_back(logEntry);
@@ -32,6 +34,7 @@ void Logger::Err(const std::string& msg) {
 	logEntry.type = LOG_ERROR;
 	logEntry.message = "ERROR: [" + CurrentDateTimeToString() + "]: " + msg;
 
+	std::lock_guard<std::mutex> lock(mutex);
 	std::cout << "\x1B[91m" << logEntry.message << "\033[0m" << std::endl;
 
 	messages.push_back(logEntry);
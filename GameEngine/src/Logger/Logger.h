@@ -3,6 +3,7 @@
 #include <iostream>
 #include <string.h>
 #include <vector>
+#include <mutex>
 
 //Enumeration that names the type of log that the Log entry is a part of
 enum LogType {
@@ -24,6 +25,8 @@ public:
 	static void Err(const std::string& msg);
 private:
 	static std::string CurrentDateTimeToString();
+	//systems can log from worker threads, the mutex keeps messages and the console in one piece
+	static std::mutex mutex;
 };
 
 #endif
\ No newline at end of file
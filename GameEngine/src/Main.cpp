@@ -1,8 +1,31 @@
 #include <iostream>
+#include <string>
 #include "Game/Game.h"
 int main(int argc, char* argv[]) {
     //TODO: start game loop
-    Game game;
+    //"--chunks" stores components in archetype chunks instead of per component pools
+    //"--broadphase=brute|grid|sap|tree" picks how the collision system finds the pairs to test
+    StorageMode storageMode = STORAGE_POOLS;
+    BroadphaseType broadphaseType = BROADPHASE_GRID;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--chunks") {
+            storageMode = STORAGE_CHUNKS;
+        }
+        else if (arg == "--broadphase=brute") {
+            broadphaseType = BROADPHASE_BRUTE_FORCE;
+        }
+        else if (arg == "--broadphase=grid") {
+            broadphaseType = BROADPHASE_GRID;
+        }
+        else if (arg == "--broadphase=sap") {
+            broadphaseType = BROADPHASE_SAP;
+        }
+        else if (arg == "--broadphase=tree") {
+            broadphaseType = BROADPHASE_TREE;
+        }
+    }
+    Game game(storageMode, broadphaseType);
 
     game.Initialize(1920,1080);//1080p 1920x1080
     game.Run();
@@ -0,0 +1,19 @@
+#ifndef RENDERRESOURCE_H
+#define RENDERRESOURCE_H
+
+#include "../AssetStore/AssetStore.h"
+#include <SDL.h>
+
+//what the render systems draw with. systems drawing to the renderer require it with ACCESS_WRITE,
+//the renderer can only be used by one of them at a time
+struct RenderResource {
+	SDL_Renderer* renderer;
+	AssetStore* assetStore;
+
+	RenderResource(SDL_Renderer* renderer = nullptr, AssetStore* assetStore = nullptr) {
+		this->renderer = renderer;
+		this->assetStore = assetStore;
+	}
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef TIMERESOURCE_H
+#define TIMERESOURCE_H
+
+#include <SDL.h>
+
+//frame timing, written by Game once per frame. ticks at the start of Game::Update,
+//deltaTime by Game::timeControl at the end of the frame
+struct TimeResource {
+	//seconds since the previous frame, multiply speeds with it to get pixels per second
+	double deltaTime;
+	//SDL_GetTicks at the start of the frame, so every system of a frame sees the same time
+	Uint32 ticks;
+
+	TimeResource(double deltaTime = 0.0, Uint32 ticks = 0) {
+		this->deltaTime = deltaTime;
+		this->ticks = ticks;
+	}
+};
+
+#endif
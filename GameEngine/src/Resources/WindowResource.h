@@ -0,0 +1,15 @@
+#ifndef WINDOWRESOURCE_H
+#define WINDOWRESOURCE_H
+
+//size of the game window in pixels, set by Game::Initialize
+struct WindowResource {
+	int width;
+	int height;
+
+	WindowResource(int width = 0, int height = 0) {
+		this->width = width;
+		this->height = height;
+	}
+};
+
+#endif
@@ -4,27 +4,32 @@
 #include "../ECS/ECS.h"
 #include "../Components/AnimationComponent.h"
 #include "../Components/SpriteComponent.h"
+#include "../Resources/TimeResource.h"
 #include <SDL.h>
 #include <string>
 
 class AnimationSystem : public System {
 	public:
 		AnimationSystem() {
-			RequireComponent<AnimationComponent>();
-			RequireComponent<SpriteComponent>();
+			RequireComponent<AnimationComponent>(ACCESS_WRITE);
+			RequireComponent<SpriteComponent>(ACCESS_WRITE);
+			RequireResource<TimeResource>(ACCESS_READ);
 		}
 
-		void Update(double deltaTime) {
-			for (auto entity : GetSystemEntities()) {
-				auto& animation = entity.GetComponent<AnimationComponent>();
-				auto& sprite = entity.GetComponent<SpriteComponent>();
-
-
-				animation.currentFrame = static_cast<int>(((SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000)) % animation.numFrames;
-
-				sprite.srcRect.x = animation.currentFrame * sprite.width;
-
-			}
+		void Update() {
+			//the frame's time, so every entity animates against the same clock
+			const Uint32 ticks = registry->GetResource<TimeResource>().ticks;
+			registry->View<AnimationComponent, SpriteComponent>().ParallelEach(
+				[ticks](Entity, AnimationComponent& animation, SpriteComponent& sprite) {
+					const int currentFrame = static_cast<int>(((ticks - animation.startTime) * animation.frameSpeedRate / 1000)) % animation.numFrames;
+					//only a new frame counts as a change of the sprite
+					if (currentFrame == animation.currentFrame && sprite.srcRect.x == currentFrame * sprite.width) {
+						return false;
+					}
+					animation.currentFrame = currentFrame;
+					sprite.srcRect.x = animation.currentFrame * sprite.width;
+					return true;
+				});
 		}
 };
 
@@ -4,65 +4,156 @@
 #include "../ECS/ECS.h"
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/TransformComponent.h"
+#include "../Collision/Broadphase.h"
+#include "../Collision/Narrowphase.h"
 #include "../Logger/Logger.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <vector>
 
 class CollisionSystem : public System {
 public:
-	CollisionSystem() {
-		RequireComponent<BoxColliderComponent>();
-		RequireComponent<TransformComponent>();
+	CollisionSystem(BroadphaseType broadphaseType = BROADPHASE_GRID) : broadphase(CreateBroadphase(broadphaseType)) {
+		RequireComponent<BoxColliderComponent>(ACCESS_READ);
+		RequireComponent<TransformComponent>(ACCESS_READ);
+	}
+
+	//the registry is only set after the constructor, so the observers are added here
+	void OnAddedToRegistry() override {
+		auto remove = [this](Entity entity) { entityIdsToRemove.push_back(entity.GetId()); };
+		registry->OnRemove<BoxColliderComponent>(remove);
+		registry->OnRemove<TransformComponent>(remove);
 	}
 
 	void Update() {
-		auto entities = GetSystemEntities();
-		
-		//loop all entities in required entites 
-		for (auto i = entities.begin(); i != entities.end(); i++)
-		{
-			//dereferenced entity at position i
-			Entity a = *i;
-			auto aTransform = a.GetComponent<TransformComponent>();
-			auto aCollider = a.GetComponent<BoxColliderComponent>();
-			//loop only entities that have not been checked yet.
-			for (auto j = i; j != entities.end(); j++) {
-				Entity b = *j;
-				//bypass check if entity is the same as itself.
-				if (a == b)
-				{
-					continue;
+		//colliders that are gone since the last frame leave the broadphase first, their ids may be in use again
+		for (int entityId : entityIdsToRemove) {
+			broadphase->Remove(entityId);
+		}
+		entityIdsToRemove.clear();
+
+		//only colliders whose box or transform was written since the last frame are moved in the broadphase.
+		//const components, collision only reads them so their change ticks are left alone
+		const unsigned int sinceTick = BeginChangeTracking();
+		registry->View<const BoxColliderComponent, const TransformComponent>().Changed<BoxColliderComponent, TransformComponent>(sinceTick).Each(
+			[this](Entity entity, const BoxColliderComponent& collider, const TransformComponent& transform) {
+				const int entityId = entity.GetId();
+				if (entityId >= static_cast<int>(colliderBoxes.size())) {
+					const size_t size = std::max(static_cast<size_t>(entityId) + 1, colliderBoxes.size() * 2);
+					colliderBoxes.resize(size);
+					colliderFilters.resize(size);
+				}
+				const float x = transform.position.x + collider.offset.x;
+				const float y = transform.position.y + collider.offset.y;
+				colliderBoxes[entityId] = { x, y, x + collider.width, y + collider.height };
+				CollisionFilter filter;
+				filter.layers = collider.layer;
+				filter.mask = collider.mask;
+				//a collider new to the broadphase starts on every layer
+				const bool isNew = !broadphase->Contains(entityId);
+				broadphase->Move(entityId, colliderBoxes[entityId]);
+				if (isNew || filter != colliderFilters[entityId]) {
+					colliderFilters[entityId] = filter;
+					broadphase->SetFilter(entityId, filter);
 				}
-				auto bTransform = b.GetComponent<TransformComponent>();
-				auto bCollider = b.GetComponent<BoxColliderComponent>();
+			});
+
+		//only pairs the broadphase found are tested box against box, all of them in one batch
+		pairs.clear();
+		broadphase->FindPairs(pairs);
+		pairBatch.Clear();
+		for (const CollisionPair& pair : pairs)
+		{
+			pairBatch.Add(colliderBoxes[pair.a], colliderBoxes[pair.b]);
+		}
+		overlappingPairs.clear();
+		pairBatch.FindOverlaps(overlappingPairs);
+		//Update runs on a worker thread, the collisions are only gathered here and reported from the main thread
+		collisions.clear();
+		for (int pairIndex : overlappingPairs)
+		{
+			collisions.push_back(pairs[pairIndex]);
+		}
+	}
 
-				bool collisionHappended = checkAABBCollision(
-					aTransform.position.x + aCollider.offset.x,
-					aTransform.position.y + aCollider.offset.y,
-					aCollider.width,
-					aCollider.height,
-					bTransform.position.x + bCollider.offset.x,
-					bTransform.position.y + bCollider.offset.y,
-					bCollider.width,
-					bCollider.height
-					);
-				if (collisionHappended) {
-					Logger::Log("Entity [" + std::to_string(a.GetId()) + "] and Entity [" + std::to_string(b.GetId()) + "] have collided");
-					
-					// TODO: emit an event...
+	//pairs of entity ids whose boxes overlapped in the last Update
+	const std::vector<CollisionPair>& GetCollisions() const {
+		return collisions;
+	}
 
-				}
+	//call from the main thread once the scheduler has run the frame's Update
+	void LogCollisions() const {
+		for (const CollisionPair& pair : collisions)
+		{
+			Logger::Log("Entity [" + std::to_string(pair.a) + "] and Entity [" + std::to_string(pair.b) + "] have collided");
+
+			// TODO: emit an event...
+
+		}
+	}
+
+	//swaps the broadphase, the colliders already in the old one are moved over
+	void SetBroadphase(BroadphaseType broadphaseType) {
+		std::unique_ptr<IBroadphase> previous = std::move(broadphase);
+		broadphase = CreateBroadphase(broadphaseType);
+		for (int entityId = 0; entityId < static_cast<int>(colliderBoxes.size()); entityId++) {
+			if (previous->Contains(entityId)) {
+				broadphase->Insert(entityId, colliderBoxes[entityId]);
+				broadphase->SetFilter(entityId, colliderFilters[entityId]);
 			}
 		}
 	}
 
-	bool checkAABBCollision(double aX, double aY, double aW, double aH, double bX, double bY, double bW, double bH)
-	{
-		return (
-			aX < bX + bW &&
-			aX + aW > bX &&
-			aY < bY + bH &&
-			aY + aH > bY 
-		);
+	//entity ids of the colliders on a layer in mask that overlap the region, as of the last Update
+	void QueryRegion(const AABB& region, std::vector<int>& entityIds, uint32_t mask = COLLISION_MASK_ALL) const {
+		const size_t first = entityIds.size();
+		broadphase->QueryRegion(region, entityIds);
+		//the broadphase may return colliders that only come close
+		entityIds.erase(std::remove_if(entityIds.begin() + first, entityIds.end(), [this, &region, mask](int entityId) {
+				return (colliderFilters[entityId].layers & mask) == 0 || !colliderBoxes[entityId].Overlaps(region);
+			}), entityIds.end());
+	}
+
+	//entity id of the first collider on a layer in mask the segment from start to end runs into, as of the
+	//last Update. -1 when it hits nothing, otherwise fraction is set to how far along the segment the hit is
+	int RayCast(const glm::vec2& start, const glm::vec2& end, float* fraction = nullptr, uint32_t mask = COLLISION_MASK_ALL) const {
+		std::vector<int> candidates;
+		broadphase->QuerySegment(start.x, start.y, end.x, end.y, candidates);
+		int closestId = -1;
+		float closestFraction = 1.0f;
+		for (int entityId : candidates) {
+			float hitFraction;
+			if ((colliderFilters[entityId].layers & mask) == 0) {
+				continue;
+			}
+			if (colliderBoxes[entityId].IntersectsSegment(start.x, start.y, end.x, end.y, hitFraction) && (closestId == -1 || hitFraction < closestFraction)) {
+				closestId = entityId;
+				closestFraction = hitFraction;
+			}
+		}
+		if (closestId != -1 && fraction != nullptr) {
+			*fraction = closestFraction;
+		}
+		return closestId;
 	}
+
+private:
+	std::unique_ptr<IBroadphase> broadphase;
+	//box of every collider in the broadphase, index = entity id
+	std::vector<AABB> colliderBoxes;
+	//layers of every collider as they were last given to the broadphase, index = entity id
+	std::vector<CollisionFilter> colliderFilters;
+	//candidate pairs of the current frame, kept to reuse the memory
+	std::vector<CollisionPair> pairs;
+	//boxes of the candidate pairs laid out for the batched test, and the positions in pairs that collided
+	PairBatch pairBatch;
+	std::vector<int> overlappingPairs;
+	//the candidate pairs that overlapped, kept until the next Update
+	std::vector<CollisionPair> collisions;
+
+	//filled by the registry's observers, applied at the start of the next Update
+	std::vector<int> entityIdsToRemove;
 };
 #endif
@@ -0,0 +1,197 @@
+#ifndef HIERARCHYSYSTEM_H
+#define HIERARCHYSYSTEM_H
+
+#include "../ECS/ECS.h"
+#include "../Components/ParentComponent.h"
+#include "../Components/TransformComponent.h"
+#include "../Logger/Logger.h"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+//works out the world transform of every entity with a parent. the entities are kept in depth first
+//order, parents before their children, so the update is one pass from the front to the back where
+//every parent is already done by the time its children are reached. only entities whose local
+//transform changed, or whose parent moved, are worked out again.
+class HierarchySystem : public System {
+	public:
+		HierarchySystem() {
+			RequireComponent<ParentComponent>(ACCESS_READ);
+			RequireComponent<TransformComponent>(ACCESS_WRITE);
+		}
+
+		//the registry is only set after the constructor, so the observers are added here
+		void OnAddedToRegistry() override {
+			//anything that can change which entities are in the hierarchy or who their parent is
+			auto reorder = [this](Entity) { isOrderDirty = true; };
+			registry->OnAdd<ParentComponent>(reorder);
+			registry->OnRemove<ParentComponent>(reorder);
+			registry->OnChange<ParentComponent>(reorder);
+			//transforms come and go on every entity, only the ones that join or leave the hierarchy reorder it
+			registry->OnAdd<TransformComponent>([this](Entity entity) {
+				if (entity.HasComponent<ParentComponent>()) {
+					isOrderDirty = true;
+				}
+			});
+			registry->OnRemove<TransformComponent>([this](Entity entity) {
+				if (IsNode(entity)) {
+					isOrderDirty = true;
+				}
+			});
+		}
+
+		void Update() {
+			//the order is only rebuilt when an entity joins, leaves or changes parent
+			if (isOrderDirty) {
+				BuildOrder();
+			}
+
+			//local transforms written since the last frame, found from the pool's change ticks in one pass
+			const unsigned int sinceTick = BeginChangeTracking();
+			registry->View<const ParentComponent>().Changed<ParentComponent>(sinceTick).Each(
+				[this](Entity entity, const ParentComponent&) {
+					const int entityId = entity.GetId();
+					if (entityId < static_cast<int>(nodeIndex.size()) && nodeIndex[entityId] >= 0) {
+						nodes[nodeIndex[entityId]].isDirty = true;
+					}
+				});
+
+			for (auto& node : nodes) {
+				const TransformComponent* parentWorld;
+				if (node.parentIndex >= 0) {
+					//the parent is a node as well and comes earlier, its world transform is already up to date
+					const Node& parent = nodes[node.parentIndex];
+					node.isDirty = node.isDirty || parent.isDirty;
+					parentWorld = &parent.world;
+				}
+				else {
+					//top of a tree, the parent is an entity without a parent of its own.
+					//a parent that was never set or was killed leaves the entity where it is, its children follow it from there
+					if (!registry->IsAlive(node.parent) || !registry->HasComponent<TransformComponent>(node.parent)) {
+						if (node.isDirty) {
+							node.world = node.entity.GetComponent<TransformComponent>();
+						}
+						continue;
+					}
+					node.isDirty = node.isDirty || registry->GetChangeTick<TransformComponent>(node.parent) > sinceTick;
+					parentWorld = &registry->GetComponent<TransformComponent>(node.parent);
+				}
+				if (!node.isDirty) {
+					continue;
+				}
+				node.world = ToWorld(*parentWorld, node.entity.GetComponent<ParentComponent>());
+				node.entity.GetComponent<TransformComponent>() = node.world;
+				registry->MarkWritten<TransformComponent>(node.entity);
+			}
+			//dirty flags are set for one frame, the children have seen them by now
+			for (auto& node : nodes) {
+				node.isDirty = false;
+			}
+		}
+
+	private:
+		struct Node {
+			Entity entity;
+			Entity parent;
+			//position of the parent in nodes, -1 when the parent has no parent itself
+			int parentIndex;
+			bool isDirty;
+			//copy of the world transform so children read their parent from the same dense array
+			TransformComponent world;
+		};
+		//every entity of the system in depth first order
+		std::vector<Node> nodes;
+		//position of each entity in nodes, index = entity id. -1 when it is not in nodes
+		std::vector<int> nodeIndex;
+
+		bool isOrderDirty = true;
+
+		//true when the entity was laid out by the last BuildOrder
+		bool IsNode(Entity entity) const {
+			const int entityId = entity.GetId();
+			return entityId < static_cast<int>(nodeIndex.size()) && nodeIndex[entityId] >= 0 && nodes[nodeIndex[entityId]].entity == entity;
+		}
+
+		//parent transform combined with a local transform, the local position is scaled and rotated with the parent
+		static TransformComponent ToWorld(const TransformComponent& parent, const ParentComponent& local) {
+			const double radians = glm::radians(parent.rotation);
+			const float cosine = static_cast<float>(std::cos(radians));
+			const float sine = static_cast<float>(std::sin(radians));
+			const glm::vec2 offset = local.localPosition * parent.scale;
+			return TransformComponent(
+				parent.position + glm::vec2(offset.x * cosine - offset.y * sine, offset.x * sine + offset.y * cosine),
+				parent.scale * local.localScale,
+				parent.rotation + local.localRotation
+			);
+		}
+
+		//lays the entities out depth first. the children of every entity are gathered into one
+		//array with an offset per entity, then each tree is walked from its top with a stack.
+		void BuildOrder() {
+			isOrderDirty = false;
+			const auto& entities = GetSystemEntities();
+			const int numEntities = static_cast<int>(entities.size());
+
+			//position of each entity in the system's entities, used to find parents
+			std::vector<int> entityIndex;
+			std::vector<int> parentOf(numEntities, -1);
+			for (int i = 0; i < numEntities; i++) {
+				const int entityId = entities[i].GetId();
+				if (entityId >= static_cast<int>(entityIndex.size())) {
+					entityIndex.resize(std::max(static_cast<size_t>(entityId) + 1, entityIndex.size() * 2), -1);
+				}
+				entityIndex[entityId] = i;
+			}
+			std::vector<int> childOffsets(numEntities + 1, 0);
+			for (int i = 0; i < numEntities; i++) {
+				const Entity parent = entities[i].GetComponent<ParentComponent>().parent;
+				const int parentId = parent.GetId();
+				if (parentId >= 0 && parentId < static_cast<int>(entityIndex.size()) && entityIndex[parentId] >= 0 && entities[entityIndex[parentId]] == parent) {
+					parentOf[i] = entityIndex[parentId];
+					childOffsets[parentOf[i] + 1]++;
+				}
+			}
+			for (int i = 0; i < numEntities; i++) {
+				childOffsets[i + 1] += childOffsets[i];
+			}
+			std::vector<int> children(childOffsets[numEntities]);
+			std::vector<int> nextChild(childOffsets.begin(), childOffsets.end() - 1);
+			for (int i = 0; i < numEntities; i++) {
+				if (parentOf[i] >= 0) {
+					children[nextChild[parentOf[i]]++] = i;
+				}
+			}
+
+			nodes.clear();
+			nodes.reserve(numEntities);
+			nodeIndex.assign(entityIndex.size(), -1);
+			std::vector<int> stack;
+			for (int root = 0; root < numEntities; root++) {
+				if (parentOf[root] != -1) {
+					continue;
+				}
+				stack.push_back(root);
+				while (!stack.empty()) {
+					const int i = stack.back();
+					stack.pop_back();
+					const Entity entity = entities[i];
+					const int parentIndex = parentOf[i] >= 0 ? nodeIndex[entities[parentOf[i]].GetId()] : -1;
+					nodeIndex[entity.GetId()] = static_cast<int>(nodes.size());
+					//everything is worked out again after a rebuild
+					nodes.push_back({ entity, entity.GetComponent<ParentComponent>().parent, parentIndex, true, TransformComponent() });
+					//pushed in reverse so the first child is walked first
+					for (int child = childOffsets[i + 1] - 1; child >= childOffsets[i]; child--) {
+						stack.push_back(children[child]);
+					}
+				}
+			}
+
+			//entities that parent each other in a loop are never reached from the top of a tree
+			if (static_cast<int>(nodes.size()) != numEntities) {
+				Logger::Err("HierarchySystem: " + std::to_string(numEntities - static_cast<int>(nodes.size())) + " entities are their own ancestor and are not updated");
+			}
+		}
+};
+
+#endif
@@ -4,30 +4,36 @@
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
+#include "../Components/StaticTag.h"
+#include "../Resources/TimeResource.h"
 #include <string>
 
 //movement system inherits from System class
 class MovementSystem : public System {
 	public:
 		MovementSystem() {
-			RequireComponent<TransformComponent>();
-			RequireComponent<RigidBodyComponent>();
+			RequireComponent<TransformComponent>(ACCESS_WRITE);
+			RequireComponent<RigidBodyComponent>(ACCESS_READ);
+			//static entities stay put even if they were given a rigid body
+			ExcludeComponent<StaticTag>();
+			RequireResource<TimeResource>(ACCESS_READ);
 		}
 		
-		void Update(double deltaTime) 
+		void Update() 
 		{
-			//Loop all entites that the system is interested in
-			for (auto entity : GetSystemEntities())
-			{
-				//you could use auto& to make it smaller. left it as reference transformcomponent to see what is happening better.
-				TransformComponent& transform = entity.GetComponent<TransformComponent>();
-				const RigidBodyComponent rigidbody = entity.GetComponent<RigidBodyComponent>();
-
-				transform.position.x += rigidbody.velocity.x * deltaTime;
-				transform.position.y += rigidbody.velocity.y * deltaTime;
-
-				Logger::Log("Entity ID: " + std::to_string(entity.GetId()) + " position is now (" + std::to_string(transform.position.x) +" ,"+ std::to_string(transform.position.x) + " )");
-			}
+			const double deltaTime = registry->GetResource<TimeResource>().deltaTime;
+			//Loop all entites that have a transform and a rigidbody, split over the thread pool.
+			//the view walks the packed components, every entity only touches its own so the tasks can run in any order
+			registry->View<TransformComponent, const RigidBodyComponent>().Without<StaticTag>().ParallelEach(
+				[deltaTime](Entity, TransformComponent& transform, const RigidBodyComponent& rigidbody) {
+					//entities standing still keep their change tick so the renderer can skip them
+					if (rigidbody.velocity.x == 0 && rigidbody.velocity.y == 0) {
+						return false;
+					}
+					transform.position.x += rigidbody.velocity.x * deltaTime;
+					transform.position.y += rigidbody.velocity.y * deltaTime;
+					return true;
+				});
 		}
 };
 
@@ -3,31 +3,48 @@
 #include "../ECS/ECS.h"
 #include "../Components/BoxColliderComponent.h"
 #include "../Components/TransformComponent.h"
+#include "../Resources/RenderResource.h"
 #include <SDL.h>
 #include "../Logger/Logger.h"
 #include <string>
+#include <vector>
+#include <algorithm>
 
 class RenderColliderSystem : public System {
 public:
 	RenderColliderSystem() {
-		RequireComponent<BoxColliderComponent>();
-		RequireComponent<TransformComponent>();
+		RequireComponent<BoxColliderComponent>(ACCESS_READ);
+		RequireComponent<TransformComponent>(ACCESS_READ);
+		RequireResource<RenderResource>(ACCESS_WRITE);
 	}
 
-	void Update(SDL_Renderer* renderer) {
-		for (auto entity : GetSystemEntities()) {
-			const auto transform = entity.GetComponent<TransformComponent>();
-			const auto collider = entity.GetComponent<BoxColliderComponent>();
-		
-			SDL_Rect colliderRect = {
-				static_cast<int>(transform.position.x + collider.offset.x),
-				static_cast<int>(transform.position.y + collider.offset.y),
-				static_cast<int>(collider.width),
-				static_cast<int>(collider.height),
-			};
-			SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-			SDL_RenderDrawRect(renderer, &colliderRect);
+	void Update() {
+		SDL_Renderer* renderer = registry->GetResource<RenderResource>().renderer;
+		//work out the outline again only for colliders whose box or transform was written since the last frame
+		const unsigned int sinceTick = BeginChangeTracking();
+		registry->View<const BoxColliderComponent, const TransformComponent>().Changed<BoxColliderComponent, TransformComponent>(sinceTick).Each(
+			[this](Entity entity, const BoxColliderComponent& collider, const TransformComponent& transform) {
+				const int entityId = entity.GetId();
+				if (entityId >= static_cast<int>(colliderRects.size())) {
+					colliderRects.resize(std::max(static_cast<size_t>(entityId) + 1, colliderRects.size() * 2));
+				}
+				colliderRects[entityId] = {
+					static_cast<int>(transform.position.x + collider.offset.x),
+					static_cast<int>(transform.position.y + collider.offset.y),
+					static_cast<int>(collider.width),
+					static_cast<int>(collider.height),
+				};
+			});
+
+		SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+		for (const auto& entity : GetSystemEntities()) {
+			SDL_RenderDrawRect(renderer, &colliderRects[entity.GetId()]);
 		}
 	}
+
+private:
+	//outline of each collider, index = entity id. a new collider is always newer than the last
+	//tracked tick, so every entity of the system has its outline filled in before it is drawn
+	std::vector<SDL_Rect> colliderRects;
 };
 #endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "../ECS/ECS.h"
 #include "../Components/SpriteComponent.h"
 #include "../Components/TransformComponent.h"
+#include "../Resources/RenderResource.h"
 #include <SDL.h>
 #include <SDL_image.h>
 #include <algorithm>
@@ -13,59 +14,165 @@
 class RenderSystem : public System {
 	public:
 		RenderSystem() {
-			RequireComponent<SpriteComponent>();
-			RequireComponent<TransformComponent>();
+			RequireComponent<SpriteComponent>(ACCESS_READ);
+			RequireComponent<TransformComponent>(ACCESS_READ);
+			RequireResource<RenderResource>(ACCESS_WRITE);
 		}
 
-		void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore)
+		//the registry is only set after the constructor, so the observers are added here. entities
+		//join the draw order through them, so the system has to be added before the entities are made
+		void OnAddedToRegistry() override
 		{
+			//anything that can move an entity in or out of the draw order, or change its place in it
+			auto reinsert = [this](Entity entity) { QueueRemove(entity); entitiesToInsert.push_back(entity); };
+			auto remove = [this](Entity entity) { QueueRemove(entity); };
+			registry->OnAdd<SpriteComponent>(reinsert);
+			registry->OnAdd<TransformComponent>(reinsert);
+			registry->OnChange<SpriteComponent>(reinsert);
+			registry->OnRemove<SpriteComponent>(remove);
+			registry->OnRemove<TransformComponent>(remove);
+		}
+
+		void Update()
+		{
+			SDL_Renderer* renderer = registry->GetResource<RenderResource>().renderer;
+			AssetStore& assetStore = *registry->GetResource<RenderResource>().assetStore;
 			//TODO: implement layer system to order the way sprites are rendered based upon what layer it belongs to.
-			//Sort all the entities of our system by z-index
-			struct RenderableEntity {
-				TransformComponent transformComponent;
-				SpriteComponent spriteComponent;
-			};
-			std::vector<RenderableEntity> renderableEntities;
-			for (auto entity : GetSystemEntities()) {
-				RenderableEntity renderableEntity;
-				renderableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
-				renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
-				renderableEntities.emplace_back(renderableEntity);
-			}
+			//Keep the entities of our system sorted by z-index, only what changed since the last frame is sorted
+			ApplyPendingChanges(assetStore);
 
-			//sort data structure
-			std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, RenderableEntity& b) {
-					return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
+			//refresh what is drawn for the entities whose sprite or transform was written since the last frame,
+			//static entities like the tiles keep what was worked out for them before
+			const unsigned int sinceTick = BeginChangeTracking();
+			registry->View<const TransformComponent, const SpriteComponent>().Changed<TransformComponent, SpriteComponent>(sinceTick).Each(
+				[this, &assetStore](Entity entity, const TransformComponent& transform, const SpriteComponent& sprite) {
+					const int entityId = entity.GetId();
+					if (entityId < static_cast<int>(drawIndex.size()) && drawIndex[entityId] >= 0)
+					{
+						Refresh(drawOrder[drawIndex[entityId]], transform, sprite, assetStore);
+					}
 				});
 
 			//Loop all entites that the system is interested in
-			for (auto entity : renderableEntities)
+			for (const auto& renderable : drawOrder)
 			{
-				const auto transform = entity.transformComponent;
-				const auto sprite = entity.spriteComponent;
-
-				//set source rectangle for out original sprite texture
-				SDL_Rect srcRect = sprite.srcRect;
-
-				//set the destination rectangle with the x,y position to be rendered
-				SDL_Rect dstRect = {
-					static_cast<int>(transform.position.x),
-					static_cast<int>(transform.position.y),
-					static_cast<int>(sprite.width * transform.scale.x),
-					static_cast<int>(sprite.height * transform.scale.y)
-				};
-
 				SDL_RenderCopyEx(
 					renderer,
-					assetStore->GetTexture(sprite.assetId),
-					&srcRect,
-					&dstRect,
-					transform.rotation,
+					renderable.texture,
+					&renderable.srcRect,
+					&renderable.dstRect,
+					renderable.rotation,
 					NULL,//center point where the rotation will happen, and null it is at the center of srcRect
 					SDL_FLIP_NONE//controls if the image is fliped
 				);
 			}
 		}
+
+	private:
+		//entities in the order they are drawn. the z-index is kept next to the entity so sorting
+		//and merging do not have to look up the sprite, and everything SDL needs to draw it is
+		//copied out of the components when they change so unchanged entities are not looked up at all.
+		struct RenderableEntity {
+			Entity entity;
+			int zIndex;
+			SDL_Texture* texture;
+			SDL_Rect srcRect;
+			SDL_Rect dstRect;
+			double rotation;
+		};
+		std::vector<RenderableEntity> drawOrder;
+		//position of each entity in drawOrder, index = entity id. -1 when it is not drawn
+		std::vector<int> drawIndex;
+
+		//filled by the registry's observers, applied at the start of the next Update
+		std::vector<int> entityIdsToRemove;
+		std::vector<Entity> entitiesToInsert;
+
+		//marks an entity in drawIndex while the removals are applied
+		static const int REMOVED = -2;
+
+		static void Refresh(RenderableEntity& renderable, const TransformComponent& transform, const SpriteComponent& sprite, AssetStore& assetStore)
+		{
+			renderable.texture = assetStore.GetTexture(sprite.assetId);
+			//set source rectangle for out original sprite texture
+			renderable.srcRect = sprite.srcRect;
+			//set the destination rectangle with the x,y position to be rendered
+			renderable.dstRect = {
+				static_cast<int>(transform.position.x),
+				static_cast<int>(transform.position.y),
+				static_cast<int>(sprite.width * transform.scale.x),
+				static_cast<int>(sprite.height * transform.scale.y)
+			};
+			renderable.rotation = transform.rotation;
+		}
+
+		void QueueRemove(Entity entity)
+		{
+			const int entityId = entity.GetId();
+			if (entityId < static_cast<int>(drawIndex.size()) && drawIndex[entityId] >= 0)
+			{
+				entityIdsToRemove.push_back(entityId);
+			}
+		}
+
+		void ApplyPendingChanges(AssetStore& assetStore)
+		{
+			if (entityIdsToRemove.empty() && entitiesToInsert.empty())
+			{
+				return;
+			}
+
+			//drop removed entities in one pass
+			if (!entityIdsToRemove.empty())
+			{
+				for (int entityId : entityIdsToRemove)
+				{
+					drawIndex[entityId] = REMOVED;
+				}
+				drawOrder.erase(std::remove_if(drawOrder.begin(), drawOrder.end(), [this](const RenderableEntity& renderable) {
+						return drawIndex[renderable.entity.GetId()] == REMOVED;
+					}), drawOrder.end());
+				for (int entityId : entityIdsToRemove)
+				{
+					drawIndex[entityId] = -1;
+				}
+				entityIdsToRemove.clear();
+			}
+
+			//sort only the new entities, then merge them into the sorted draw order.
+			//equal z-indexes keep the order they were added in.
+			const size_t numSorted = drawOrder.size();
+			for (const auto& entity : entitiesToInsert)
+			{
+				const int entityId = entity.GetId();
+				if (!HasEntity(entity) || !entity.IsAlive() || (entityId < static_cast<int>(drawIndex.size()) && drawIndex[entityId] != -1))
+				{
+					continue;
+				}
+				if (entityId >= static_cast<int>(drawIndex.size()))
+				{
+					drawIndex.resize(std::max(static_cast<size_t>(entityId) + 1, drawIndex.size() * 2), -1);
+				}
+				const auto& sprite = entity.GetComponent<SpriteComponent>();
+				RenderableEntity renderable{ entity, sprite.zIndex, nullptr, {}, {}, 0.0 };
+				Refresh(renderable, entity.GetComponent<TransformComponent>(), sprite, assetStore);
+				//any value but -1 marks the entity as drawn, the real positions are set below
+				drawIndex[entityId] = 0;
+				drawOrder.push_back(renderable);
+			}
+			entitiesToInsert.clear();
+
+			auto byZIndex = [](const RenderableEntity& a, const RenderableEntity& b) {
+				return a.zIndex < b.zIndex;
+			};
+			std::stable_sort(drawOrder.begin() + numSorted, drawOrder.end(), byZIndex);
+			std::inplace_merge(drawOrder.begin(), drawOrder.begin() + numSorted, drawOrder.end(), byZIndex);
+
+			for (size_t i = 0; i < drawOrder.size(); i++)
+			{
+				drawIndex[drawOrder[i].entity.GetId()] = static_cast<int>(i);
+			}
+		}
 };
 
 
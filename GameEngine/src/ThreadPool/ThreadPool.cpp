@@ -0,0 +1,115 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+	//which pool the current thread works for and the index of its queue in that pool
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local unsigned int currentQueueIndex = 0;
+}
+
+ThreadPool::ThreadPool(unsigned int numThreads) {
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	const unsigned int numWorkers = numThreads - 1;
+
+	for (unsigned int i = 0; i <= numWorkers; i++) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (unsigned int i = 0; i < numWorkers; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		isStopping = true;
+	}
+	wakeCondition.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+unsigned int ThreadPool::GetQueueIndex() const {
+	return currentPool == this ? currentQueueIndex : static_cast<unsigned int>(queues.size()) - 1;
+}
+
+void ThreadPool::Submit(TaskGroup& group, std::function<void()> task) {
+	group.pending.fetch_add(1, std::memory_order_relaxed);
+
+	WorkQueue& queue = *queues[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back({ std::move(task), &group });
+	}
+
+	//counting under the sleep mutex means a worker can not miss the wake up between checking and sleeping
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedTasks.fetch_add(1, std::memory_order_relaxed);
+	}
+	wakeCondition.notify_one();
+}
+
+bool ThreadPool::TryRunTask(unsigned int queueIndex) {
+	Task task;
+	bool hasTask = false;
+
+	//newest task from our own queue first, it is the most likely to still be in cache
+	{
+		WorkQueue& queue = *queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			hasTask = true;
+		}
+	}
+
+	//otherwise steal the oldest task from the other queues
+	for (unsigned int i = 1; !hasTask && i < queues.size(); i++) {
+		WorkQueue& queue = *queues[(queueIndex + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			hasTask = true;
+		}
+	}
+
+	if (!hasTask) {
+		return false;
+	}
+	queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+	task.function();
+	task.group->pending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void ThreadPool::Wait(TaskGroup& group) {
+	const unsigned int queueIndex = GetQueueIndex();
+	while (!group.IsDone()) {
+		if (!TryRunTask(queueIndex)) {
+			//the remaining tasks are running on other threads
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ThreadPool::WorkerLoop(unsigned int queueIndex) {
+	currentPool = this;
+	currentQueueIndex = queueIndex;
+
+	while (true) {
+		if (TryRunTask(queueIndex)) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeCondition.wait(lock, [this]() { return isStopping || queuedTasks.load(std::memory_order_relaxed) > 0; });
+		if (isStopping) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+// T H R E A D   P O O L
+/////////////////////////////////////////////////////////////////////////////
+// Work stealing thread pool. every worker owns a queue, it takes work from
+// the back of its own queue and steals from the front of the others when it
+// runs out. tasks submitted from outside the pool go to a shared queue.
+// a thread waiting on a TaskGroup runs queued tasks instead of blocking, so
+// tasks can submit more tasks and wait on them without deadlocking the pool.
+/////////////////////////////////////////////////////////////////////////////
+
+//counts the unfinished tasks of a batch so the submitter can wait for them
+class TaskGroup {
+	public:
+		bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+	private:
+		friend class ThreadPool;
+		std::atomic<int> pending{ 0 };
+};
+
+class ThreadPool {
+	public:
+		//numThreads counts the thread that waits on the pool, so numThreads - 1 workers are started.
+		//0 uses every hardware thread. 1 starts no workers and runs every task inside Wait.
+		ThreadPool(unsigned int numThreads = 0);
+		~ThreadPool();
+
+		//number of threads that run tasks, including the waiting thread
+		unsigned int GetNumThreads() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+		//queues a task as part of group
+		void Submit(TaskGroup& group, std::function<void()> task);
+		//runs queued tasks on the calling thread until every task in group has finished
+		void Wait(TaskGroup& group);
+
+	private:
+		struct Task {
+			std::function<void()> function;
+			TaskGroup* group;
+		};
+		struct WorkQueue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		void WorkerLoop(unsigned int queueIndex);
+		//pops a task from the queue at queueIndex, or steals one from another queue. returns false if there was none
+		bool TryRunTask(unsigned int queueIndex);
+		//queue used by the calling thread, workers have their own and everyone else shares the last one
+		unsigned int GetQueueIndex() const;
+
+		//one queue per worker, plus the shared queue at the end
+		std::vector<std::unique_ptr<WorkQueue>> queues;
+		std::vector<std::thread> workers;
+
+		//idle workers sleep until a task is queued
+		std::mutex sleepMutex;
+		std::condition_variable wakeCondition;
+		std::atomic<int> queuedTasks{ 0 };
+		bool isStopping = false;
+};
+
+#endif